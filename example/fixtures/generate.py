@@ -0,0 +1,443 @@
+#!/usr/bin/env python3
+#
+# <z64.me> generate.py - write the fixture scenes in example/fixtures
+#
+# usage: python3 example/fixtures/generate.py [directory]
+#
+# every scene replayed by `make bench` (see digests.txt) is written
+# here, byte for byte; `make fixtures` rewrites them in place, and
+# `git status` should then show nothing changed
+#
+# a digest only says the output did not change, not that it was
+# right to begin with, so above each scene is how its digests were
+# checked when they were first recorded; besides that, every line
+# of digests.txt gives the same digest with the bench built with
+# `-DBAKE_BUDGET=0` added to HOSTCFLAGS (nothing baked: segments
+# are generated frame by frame) and with `-DARENA_SIZE=0x8000`
+# (every list compiled in full), -m left out for the latter, save
+# the -m 0x900 lines of arena and noroom, which leave segments out
+# on purpose; twin lines in digests.txt (same digest, other
+# arguments) are checks that `make bench` repeats every time
+#
+# the engine as it was before these commands existed cannot serve
+# as a reference: it wrote each segment's commands to graph memory
+# every frame, so its display lists differ from these even where
+# what they draw does not
+#
+
+import os
+import random
+import struct
+import sys
+
+def be16(v):
+	return struct.pack('>H', v & 0xFFFF)
+
+def be32(v):
+	return struct.pack('>I', v & 0xFFFFFFFF)
+
+# struct flag
+def flag(type=0, flag=0, and_=0, eq=1, xfade=0, freeze=0, frames=0):
+	return (be32(flag) + be32(and_) + bytes([type, eq])
+		+ be16(xfade) + be16(freeze) + be16(frames))
+
+# struct colorlist; keys are (prim, env, lodfrac, minlevel, next),
+# and the terminating key is appended
+def colorlist(keys, which=3, ease=0, dur=None):
+	body = b''
+	for p, e, l, m, n in keys:
+		body += be32(p) + be32(e) + bytes([l, m]) + be16(n)
+	body += be32(0) + be32(0) + bytes([0, 0]) + be16(0)
+	if dur is None:
+		dur = sum(k[4] for k in keys)
+	return bytes([which, ease]) + be16(dur) + body
+
+# struct colorlist_packed, as src/util/colorpack.c writes it;
+# keys are (next, prim, env, lodfrac, minlevel)
+def packed(keys, which=3, ease=0, dur=None, palette=None):
+	pal = palette or []
+	if dur is None:
+		dur = sum(k[0] for k in keys)
+	out = bytes([which, ease]) + be16(dur) + be16(len(keys)) + be16(len(pal))
+	for c in pal:
+		out += be32(c)
+	for n, p, e, l, m in keys:
+		out += bytes([n])
+		for bit, c in ((1, p), (2, e)):
+			if which & bit:
+				out += bytes([pal.index(c)]) if pal else be32(c)
+		if which & 4:
+			out += bytes([l])
+		if which & 8:
+			out += bytes([m])
+	return out
+
+# a scene file holding only a header and what is added to it;
+# add() returns the segment 0x02 address of what it added
+class Scene:
+	def __init__(self):
+		self.data = bytearray(0x40) # header, written by save()
+
+	def add(self, blob, align=8):
+		while len(self.data) % align:
+			self.data.append(0)
+		ofs = len(self.data)
+		self.data += blob
+		return 0x02000000 | ofs
+
+	# animation list; items are (segment 1-based, every, type, data)
+	def anims(self, items):
+		out = b''
+		for i, (seg, every, type, addr) in enumerate(items):
+			if i == len(items) - 1:
+				seg = -seg
+			out += struct.pack('>bBHI', seg, every, type, addr)
+		return self.add(out)
+
+	# 0x1A command pointing to an animation list, then 0x14 (end)
+	def header(self, anims):
+		return be32(0x1A000000) + be32(anims) + be32(0x14000000) + be32(0)
+
+	# alternate setups get a 0x18 command and headers of their own
+	def save(self, fn, anims, alts=()):
+		head = self.header(anims)
+		if alts:
+			alts = [self.add(self.header(a)) for a in alts]
+			table = self.add(b''.join(be32(a) for a in alts) + be32(0))
+			head = be32(0x18000000) + be32(table) + head
+		self.data[0:len(head)] = head
+		while len(self.data) % 16:
+			self.data.append(0)
+		with open(fn, 'wb') as fp:
+			fp.write(self.data)
+
+# two keys, used wherever a color list only has to be present
+def colors(s):
+	return s.add(colorlist([
+		(0xFF0000FF, 0x00FF00FF, 0, 0, 5),
+		(0x0000FFFF, 0xFFFFFFFF, 0, 0, 3),
+	]))
+
+# room.zmap: filler data, so 0x03 addresses resolve somewhere
+def room(fn):
+	with open(fn, 'wb') as fp:
+		fp.write(bytes((i * 7 + 3) & 0xFF for i in range(0x400)))
+
+# arena.zscene: twelve color lists of 6 keys and four of 60, random;
+# for -m 0x900, a -d dump was compared against one without -m: the
+# segments reported on stderr are the only ones writing nothing
+def arena(fn):
+	r = random.Random(6)
+	s = Scene()
+	def keys(n):
+		return [(
+			r.getrandbits(32), r.getrandbits(32),
+			r.getrandbits(8), r.getrandbits(8), r.randint(1, 9)
+		) for _ in range(n)]
+	items = []
+	for i in range(12):
+		items.append((1 + i % 4, 0, 0x0009, s.add(colorlist(keys(6)))))
+	for i in range(4):
+		items.append((5 + i, 0, 0x0009, s.add(colorlist(keys(60)))))
+	s.save(fn, s.anims(items))
+
+# noroom.zscene: a long color list, then a pointer list, sharing a
+# segment; sized so the pointer list is what -m 0x900 leaves out
+# (206 keys; growing the engine's structures can move this, so
+# check again when the digest changes); checked with -d that the
+# color commands are still written
+def noroom(fn):
+	r = random.Random(8)
+	s = Scene()
+	tex = [s.add(bytes(range(256)) * 2) for _ in range(2)]
+	keys = [
+		(r.getrandbits(32), r.getrandbits(32), 0, 0, r.randint(1, 4))
+		for _ in range(206)
+	]
+	c = s.add(colorlist(keys))
+	ptrs = [tex[i & 1] for i in range(40)]
+	pl = s.add(be16(80) + be16(0) + be16(2) + be16(0)
+		+ b''.join(be32(p) for p in ptrs))
+	s.save(fn, s.anims([(1, 0, 0x0009, c), (1, 0, 0x000B, pl)]))
+
+# timeloop body (0x000D) of struct pointer_timeloop
+def timeloop(each, ptrs):
+	n = len(each)
+	out = be16(0) + be16(0) + be16(n) + b''.join(be16(e) for e in each)
+	if not n & 1:
+		out += be16(0)
+	return out + b''.join(be32(p) for p in ptrs)
+
+# short.zscene: 0x000D, 0x000E and 0x0014 with fewer than two
+# entries; the build before the fix crashed on it; the -d dump was
+# read to confirm those steps write nothing and the others animate
+def short(fn):
+	s = Scene()
+	tex = [s.add(bytes(range(256)) * 2) for _ in range(3)]
+	col = s.add(colorlist([
+		(0xFF0000FF, 0x00FF00FF, 0, 0, 10),
+		(0x0000FFFF, 0xFFFFFFFF, 0, 0, 6),
+	]))
+	t1 = s.add(timeloop([0], []))
+	t2 = s.add(timeloop([0, 4, 9], tex[:2]))
+	t0 = s.add(flag(type=8) + timeloop([], []))
+	atl1 = s.add(bytes([0, 0, 16, 16]) + be16(1) + be16(0))
+	atl = s.add(bytes([1, 0, 16, 16]) + be16(3)
+		+ be16(0) + be16(5) + be16(12))
+	s.save(fn, s.anims([
+		(1, 0, 0x000D, t1), (1, 0, 0x0009, col),
+		(2, 0, 0x0014, atl1), (2, 0, 0x0014, atl),
+		(3, 0, 0x000E, t0),
+		(4, 0, 0x000D, t2),
+	]))
+
+# scroll.zscene: 0x0000 and 0x0001, stationary layers included;
+# the -d dump was read to confirm offsets wrap at the texture size
+def scroll(fn):
+	s = Scene()
+	a = s.add(bytes([1, 0xFF, 32, 32]))
+	b = s.add(bytes([0x7F, 0x81, 0, 0]))
+	c = s.add(bytes([2, 0xFE, 64, 16, 0xFD, 5, 24, 40]))
+	d = s.add(bytes([0, 0, 32, 32, 0, 0, 16, 16]))
+	s.save(fn, s.anims([
+		(1, 0, 0x0000, a), (2, 0, 0x0000, b),
+		(3, 0, 0x0001, c), (4, 0, 0x0001, d),
+	]))
+
+# struct palette_loop (0x0013)
+def palloop(base, stride, num, each, count, slot):
+	return (be32(base) + be32(stride) + be16(num) + be16(each)
+		+ be16(count) + be16(slot))
+
+# bake.zscene: baked segments over two setups, a palette in the
+# room; both lines matched the engine as it was before this scene
+# was added
+def bake(fn):
+	s = Scene()
+	pl0 = s.add(palloop(0x03000100, 0x20, 4, 3, 16, 0))
+	pl1 = s.add(palloop(0x03000200, 0, 3, 5, 16, 2))
+	sc0 = s.add(bytes([1, 2, 32, 32]))
+	sc1 = s.add(bytes([0xFF, 1, 16, 32, 3, 0xFE, 64, 16]))
+	col = colors(s)
+	main = s.anims([
+		(1, 0, 0x0013, pl0), (2, 0, 0x0000, sc0), (3, 0, 0x0009, col),
+	])
+	alt = s.anims([
+		(1, 0, 0x0013, pl1), (1, 0, 0x0009, col), (2, 0, 0x0001, sc1),
+	])
+	s.save(fn, main, [alt])
+
+# wobble.zscene: camera wobble and shake (0x000F); the bench digests
+# what the camera is asked to do; both lines match the engine from
+# before the wobble table moved into the list's storage
+def wobble(fn):
+	s = Scene()
+	w1 = s.add(flag(type=8) + bytes([1, 0]) + b'\0\0')
+	w2 = s.add(flag(type=8, eq=0) + bytes([1, 0]) + b'\0\0')
+	sh = s.add(flag(type=8) + bytes([0, 0]) + b'\0\0')
+	col = colors(s)
+	s.save(fn, s.anims([
+		(1, 0, 0x000F, w1), (1, 0, 0x0009, col),
+		(2, 0, 0x000F, w2), (3, 0, 0x000F, sh),
+	]))
+
+# every.zscene: update intervals on several types; matches the
+# engine from before intervals stopped being baked
+def every(fn):
+	s = Scene()
+	sc = s.add(bytes([3, 0xFE, 32, 32]))
+	sc2 = s.add(bytes([1, 2, 64, 16, 0xFF, 5, 32, 32]))
+	tiles = s.add(be16(3) + bytes([
+		0, 1, 0xFF, 32, 32,
+		1, 2, 3, 16, 64,
+		2, 0xFD, 0, 8, 8,
+	]))
+	col = s.add(colorlist([
+		(0xFF0000FF, 0x00FF00FF, 0, 0, 5),
+		(0x0000FFFF, 0xFFFFFFFF, 0x40, 2, 3),
+		(0x808080FF, 0x102030FF, 0x80, 1, 9),
+	]))
+	pals = s.add(bytes((i * 13 + 5) & 0xFF for i in range(3 * 32)))
+	pal = s.add(palloop(pals, 32, 3, 5, 16, 0))
+	s.save(fn, s.anims([
+		(1, 4, 0x0000, sc), (1, 0, 0x0009, col),
+		(2, 3, 0x0001, sc2), (2, 2, 0x0013, pal),
+		(3, 5, 0x0015, tiles), (4, 3, 0x0009, col), (4, 0, 0x0015, tiles),
+	]))
+
+# tiles.zscene: 0x0015 and 0x0016 naming their own tiles; both
+# lines match the engine from before 0x0015 was rewritten around
+# scroll_layer
+def tiles(fn):
+	s = Scene()
+	t = s.add(be16(4) + bytes([
+		0, 1, 0xFF, 32, 32,
+		1, 0x7F, 3, 0, 64,
+		5, 0x80, 0, 24, 40,
+		7, 0, 0, 16, 16,
+	]))
+	ft = s.add(flag(type=8) + be16(2) + bytes([
+		2, 2, 0xFE, 48, 8,
+		3, 0xF0, 9, 128, 0,
+	]))
+	sc = s.add(bytes([1, 0xFF, 32, 32, 0xFE, 3, 64, 0]))
+	s.save(fn, s.anims([
+		(1, 0, 0x0015, t), (2, 0, 0x0016, ft),
+		(3, 0, 0x0001, sc), (4, 6, 0x0015, t),
+	]))
+
+# packed.zscene: packed color lists (0x0017, 0x0018), with and
+# without palettes; matches the engine from before packed keys
+# were read in place
+def packed_(fn):
+	s = Scene()
+	pal = [
+		0xFF0000FF, 0x00FF00FF, 0x0000FFFF, 0xFFFFFFFF,
+		0x102030FF, 0x80808080, 0x000000FF, 0xC0FFEE00,
+	]
+	k1 = [(1 + i % 5, pal[i % 8], pal[(i * 3) % 8], 0, 0) for i in range(300)]
+	k2 = [(
+		1 + (i * 7) % 4,
+		(i * 0x01030507) & 0xFFFFFFFF, (i * 0x0B0D1113) & 0xFFFFFFFF,
+		i & 0xFF, i % 7
+	) for i in range(300)]
+	a = s.add(packed(k1, which=3, ease=1, palette=pal))
+	b = s.add(packed(k2, which=0xF, ease=4))
+	c = s.add(flag(type=8, xfade=6) + packed(k1[:200], which=1, palette=pal))
+	s.save(fn, s.anims([
+		(1, 0, 0x0017, a), (2, 0, 0x0017, b), (3, 0, 0x0018, c),
+	]))
+
+# cdraw.zscene: conditional draws (0x0010); the -d dump was read
+# to confirm each segment selects a zero matrix while hidden and
+# an identity matrix while shown, switching with the flag
+def cdraw(fn):
+	s = Scene()
+	on = s.add(flag(type=8))
+	off = s.add(flag(type=8, eq=0))
+	col = colors(s)
+	s.save(fn, s.anims([
+		(1, 0, 0x0010, on), (2, 0, 0x0010, off),
+		(3, 0, 0x0010, on), (3, 0, 0x0009, col),
+	]))
+
+# stride.zscene: evenly spaced pointers (0x0011, 0x0012); with loop
+# set, stride_loop.zscene: the same lists as 0x000B/0x000C, which
+# must give the same digests; bin/util/stridepack, given each list
+# of stride_loop.zscene, writes what stride.zscene holds
+def stride(fn, loop=False):
+	s = Scene()
+	frames = s.add(b''.join(
+		be32(0xDE000000 + i) + be32(0) + be32(0xDF000000) + be32(0)
+		for i in range(6)
+	))
+	items = []
+	for seg, num, each, f in (
+		(1, 6, 3, None), (2, 4, 1, None),
+		(3, 5, 7, flag(type=8)), (4, 3, 2, flag(type=8, eq=0)),
+	):
+		if loop:
+			body = (be16(num * each) + be16(0) + be16(each) + be16(0)
+				+ b''.join(be32(frames + i * 16) for i in range(num)))
+			type = 0x000B
+		else:
+			body = be32(frames) + be32(16) + be16(num) + be16(each)
+			type = 0x0011
+		if f:
+			body = f + body
+			type += 1
+		items.append((seg, 0, type, s.add(body)))
+	s.save(fn, s.anims(items))
+
+# longstride.zscene: 300 pointers of 300 frames each (0x0011), a
+# 90000 frame cycle; the engine once kept cycles in 16 bits, and
+# went back to the first pointer after the 82nd; checked with -d
+# that the last pointer is shown from frame 89700, the first again
+# from frame 90000
+def longstride(fn):
+	s = Scene()
+	frames = s.add(b''.join(
+		be32(0xDE000000 + i) + be32(0) + be32(0xDF000000) + be32(0)
+		for i in range(300)
+	))
+	list = s.add(be32(frames) + be32(16) + be16(300) + be16(300))
+	s.save(fn, s.anims([(1, 0, 0x0011, list)]))
+
+# palette.zscene: palettes (0x0013), CI4 and CI8, in the scene and
+# the room; moving the room (-r) gives the same digest as not
+# moving it; the -d dump loads each from its segmented address
+# (02xxxxxx, 03xxxxxx), which the digest counts the same as the
+# ram addresses loaded before
+def palette(fn):
+	s = Scene()
+	pals = s.add(bytes((i * 29 + 11) & 0xFF for i in range(5 * 32)))
+	a = s.add(palloop(pals, 32, 5, 3, 16, 2))
+	b = s.add(palloop(0x03000000, 32, 8, 1, 16, 0))
+	c = s.add(palloop(0x03000000, 0x200, 2, 200, 256, 0))
+	d = s.add(palloop(0x03000040, 32, 7, 5, 16, 15))
+	s.save(fn, s.anims([
+		(1, 3, 0x0013, a), (2, 0, 0x0013, b),
+		(3, 0, 0x0013, c), (4, 0, 0x0013, d),
+	]))
+
+# longpalette.zscene: three palettes of 30000 frames each (0x0013),
+# a 90000 frame cycle, which 16 bits cannot count; checked with -d
+# that each palette is loaded in turn, the first again from frame
+# 90000
+def longpalette(fn):
+	s = Scene()
+	pals = s.add(bytes((i * 29 + 11) & 0xFF for i in range(3 * 32)))
+	pl = s.add(palloop(pals, 32, 3, 30000, 16, 0))
+	s.save(fn, s.anims([(1, 0, 0x0013, pl)]))
+
+# atlas.zscene: atlas flipbooks (0x0014); every tile size in a 600
+# frame -d dump was compared against the frame each schedule
+# selects, worked out separately
+def atlas(fn):
+	s = Scene()
+	def timeloop(tile, w, h, each):
+		return s.add(bytes([tile, 0, w, h]) + be16(len(each))
+			+ b''.join(be16(e) for e in each))
+	a = timeloop(0, 16, 16, [0, 4, 5, 12, 20, 21, 30, 38, 40])
+	b = timeloop(3, 32, 8, [0, 1, 2, 3, 4, 5, 6, 7, 8])
+	c = timeloop(1, 8, 8, [0, 100, 150, 400])
+	s.save(fn, s.anims([
+		(1, 0, 0x0014, a), (2, 0, 0x0014, b),
+		(3, 0, 0x0014, c), (4, 4, 0x0014, a),
+	]))
+
+# atlas256.zscene: atlas frames of size 0, meaning 256; the -d dump
+# sets tile sizes (0, 0)-(3FC, 3FC), then (0, 400)-(3FC, 7FC), etc.
+def atlas256(fn):
+	s = Scene()
+	a = s.add(bytes([0, 0, 0, 0]) + be16(4) + be16(0) + be16(10)
+		+ be16(20) + be16(30))
+	b = s.add(bytes([1, 0, 0, 16]) + be16(3) + be16(0) + be16(5)
+		+ be16(10))
+	s.save(fn, s.anims([(1, 0, 0x0014, a), (2, 0, 0x0014, b)]))
+
+FIXTURES = (
+	('room.zmap', room),
+	('arena.zscene', arena),
+	('noroom.zscene', noroom),
+	('short.zscene', short),
+	('scroll.zscene', scroll),
+	('bake.zscene', bake),
+	('wobble.zscene', wobble),
+	('every.zscene', every),
+	('tiles.zscene', tiles),
+	('packed.zscene', packed_),
+	('cdraw.zscene', cdraw),
+	('stride.zscene', stride),
+	('stride_loop.zscene', lambda fn: stride(fn, loop=True)),
+	('longstride.zscene', longstride),
+	('palette.zscene', palette),
+	('atlas.zscene', atlas),
+	('atlas256.zscene', atlas256),
+	('longpalette.zscene', longpalette),
+)
+
+if __name__ == '__main__':
+	out = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(__file__)
+	for name, write in FIXTURES:
+		write(os.path.join(out, name))
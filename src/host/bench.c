@@ -0,0 +1,929 @@
+/****************************************************
+ * <z64.me> bench.c - replay z64scene.c on the host *
+ ****************************************************/
+
+/* this builds alongside z64scene.c (see `make bench`) and drives *
+ * its main() once per simulated frame, reporting frame times,    *
+ * per-handler times, and display list bytes generated; a digest  *
+ * of the generated display lists is printed as well, so changes  *
+ * to the engine can be checked for identical output              */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "host.h"
+#include "../types.h"
+
+/* bounds of this program's image, set by the linker */
+extern char __executable_start[];
+extern char end[];
+
+/* z64scene.c's main(), renamed by the makefile */
+void z64scene_main(z64_global_t *gl);
+
+#define GRAPH_SIZE     0x20000  /* bytes per display buffer */
+#define HANDLER_MAX    0x40     /* handler types tracked     */
+
+/* state the stubs read from */
+z64_save_context_t z64_host_save;
+uint32_t z64_host_is_night;
+
+static struct
+{
+	/* loaded files (segments 02 and 03) */
+	uint8_t        *scene;
+	uint32_t        scene_sz;
+	uint8_t        *room;
+	uint32_t        room_sz;
+	uint8_t        *room_slot[2]; /* room is loaded into either */
+
+	/* graphics */
+	z64_gfx_t       gfx;
+	uint8_t        *graph;      /* every display buffer lives in here */
+	uint32_t        graph_sz;
+	uint32_t        graph_allocs;
+
+	/* zelda arena; 0 = no limit */
+	uint32_t        heap_max;
+	uint32_t        heap_used;
+
+	/* simulated flags; all of them toggle every `period` frames */
+	int             flags_on;
+
+	/* per-handler timing */
+	struct timespec handler_start;
+	uint64_t        handler_ns[HANDLER_MAX];
+	uint64_t        handler_calls[HANDLER_MAX];
+
+	/* digest of generated display lists */
+	uint64_t        digest;
+	int             dump;
+} host;
+
+/*
+ *
+ * memory
+ *
+ */
+
+/* allocate memory addressable by 32-bit display list words */
+static
+void *
+low_alloc(uint32_t sz)
+{
+	void *p = mmap(
+		0, sz
+		, PROT_READ | PROT_WRITE
+		, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT
+		, -1, 0
+	);
+
+	if (p == MAP_FAILED)
+	{
+		fprintf(stderr, "failed to allocate %u bytes\n", sz);
+		exit(EXIT_FAILURE);
+	}
+
+	return p;
+}
+
+static
+uint8_t *
+file_load(const char *fn, uint32_t *sz)
+{
+	FILE *fp = fopen(fn, "rb");
+	uint8_t *data;
+
+	if (!fp)
+	{
+		fprintf(stderr, "failed to open '%s'\n", fn);
+		exit(EXIT_FAILURE);
+	}
+
+	fseek(fp, 0, SEEK_END);
+	*sz = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	data = low_alloc(*sz + 16);
+	if (fread(data, 1, *sz, fp) != *sz)
+	{
+		fprintf(stderr, "failed to read '%s'\n", fn);
+		exit(EXIT_FAILURE);
+	}
+
+	fclose(fp);
+	return data;
+}
+
+/*
+ *
+ * byte swapping (scene files are big-endian)
+ *
+ */
+
+/* offsets of structures already swapped, so shared data is *
+ * never swapped twice                                      */
+static uint8_t *swapped;
+
+static
+int
+swap_once(uint32_t ofs)
+{
+	if (swapped[ofs])
+		return 0;
+	swapped[ofs] = 1;
+	return 1;
+}
+
+static
+void
+swap16(void *v)
+{
+	uint8_t *b = v;
+	uint8_t t = b[0];
+
+	b[0] = b[1];
+	b[1] = t;
+}
+
+static
+void
+swap32(void *v)
+{
+	uint8_t *b = v;
+	uint8_t t;
+
+	t = b[0]; b[0] = b[3]; b[3] = t;
+	t = b[1]; b[1] = b[2]; b[2] = t;
+}
+
+/* scene-relative pointer from segment address; 0 if invalid */
+static
+void *
+scene_ptr(uint32_t addr)
+{
+	if (addr >> 24 != 0x02 || (addr & 0xFFFFFF) >= host.scene_sz)
+		return 0;
+
+	return host.scene + (addr & 0xFFFFFF);
+}
+
+static
+void
+swap_flag(struct flag *f)
+{
+	swap32(&f->flag);
+	swap32(&f->and);
+	swap16(&f->xfade);
+	swap16(&f->freeze);
+	swap16(&f->frames);
+}
+
+static
+void
+swap_colorlist(struct colorlist *list)
+{
+	struct colorkey *key;
+
+	swap16(&list->dur);
+
+	/* NOTE: prim and env are consumed as bytes, so they are left as-is */
+	for (key = list->key; ; ++key)
+	{
+		swap16(&key->next);
+		if (!key->next)
+			break;
+	}
+}
+
+/* NOTE: the palette and keys are all bytes, so only the header is swapped */
+static
+void
+swap_colorlist_packed(struct colorlist_packed *list)
+{
+	swap16(&list->dur);
+	swap16(&list->num);
+	swap16(&list->colors);
+}
+
+static
+void
+swap_pointer_loop(struct pointer_loop *ptr)
+{
+	int i;
+	int num;
+
+	swap16(&ptr->dur);
+	swap16(&ptr->time);
+	swap16(&ptr->each);
+
+	num = ptr->each ? (ptr->dur + ptr->each - 1) / ptr->each : 0;
+	for (i = 0; i < num; ++i)
+		swap32(&ptr->ptr[i]);
+}
+
+static
+void
+swap_pointer_timeloop(struct pointer_timeloop *ptr)
+{
+	int i;
+	uint32_t *list;
+
+	swap16(&ptr->prev);
+	swap16(&ptr->time);
+	swap16(&ptr->num);
+
+	for (i = 0; i < ptr->num; ++i)
+		swap16(&ptr->each[i]);
+
+	list = (void*)(ptr->each + ptr->num + !(ptr->num & 1));
+	for (i = 0; i < ptr->num - 1; ++i)
+		swap32(&list[i]);
+}
+
+static
+void
+swap_pointer_stride(struct pointer_stride *ptr)
+{
+	swap32(&ptr->base);
+	swap32(&ptr->stride);
+	swap16(&ptr->num);
+	swap16(&ptr->each);
+}
+
+static
+void
+swap_palette_loop(struct palette_loop *pal)
+{
+	swap32(&pal->base);
+	swap32(&pal->stride);
+	swap16(&pal->num);
+	swap16(&pal->each);
+	swap16(&pal->count);
+	swap16(&pal->pal);
+}
+
+static
+void
+swap_atlas_timeloop(struct atlas_timeloop *al)
+{
+	int i;
+
+	swap16(&al->num);
+
+	for (i = 0; i < al->num; ++i)
+		swap16(&al->each[i]);
+}
+
+static
+void
+swap_anim_data(int type, void *data)
+{
+	switch (type)
+	{
+		case 0x0007: {
+			struct pointer_flag *ptr = data;
+			swap32(&ptr->ptr[0]);
+			swap32(&ptr->ptr[1]);
+			swap_flag(&ptr->flag);
+			break;
+		}
+
+		case 0x0008:
+			swap_flag(&((struct scroll_flag*)data)->flag);
+			break;
+
+		case 0x0009:
+			swap_colorlist(data);
+			break;
+
+		case 0x000A:
+			swap_flag(&((struct colorlist_flag*)data)->flag);
+			swap_colorlist(&((struct colorlist_flag*)data)->list);
+			break;
+
+		case 0x000B:
+			swap_pointer_loop(data);
+			break;
+
+		case 0x000C:
+			swap_flag(&((struct pointer_loop_flag*)data)->flag);
+			swap_pointer_loop(&((struct pointer_loop_flag*)data)->list);
+			break;
+
+		case 0x000D:
+			swap_pointer_timeloop(data);
+			break;
+
+		case 0x000E:
+			swap_flag(&((struct pointer_timeloop_flag*)data)->flag);
+			swap_pointer_timeloop(&((struct pointer_timeloop_flag*)data)->list);
+			break;
+
+		case 0x000F:
+			swap_flag(&((struct cameraeffect*)data)->flag);
+			break;
+
+		case 0x0010:
+			swap_flag(&((struct conditionaldraw*)data)->flag);
+			break;
+
+		case 0x0011:
+			swap_pointer_stride(data);
+			break;
+
+		case 0x0012:
+			swap_flag(&((struct pointer_stride_flag*)data)->flag);
+			swap_pointer_stride(&((struct pointer_stride_flag*)data)->list);
+			break;
+
+		case 0x0013:
+			swap_palette_loop(data);
+			break;
+
+		case 0x0014:
+			swap_atlas_timeloop(data);
+			break;
+
+		/* NOTE: tiles are all bytes, so only the count is swapped */
+		case 0x0015:
+			swap16(&((struct scroll_tiles*)data)->num);
+			break;
+
+		case 0x0016:
+			swap_flag(&((struct scroll_tiles_flag*)data)->flag);
+			swap16(&((struct scroll_tiles_flag*)data)->list.num);
+			break;
+
+		case 0x0017:
+			swap_colorlist_packed(data);
+			break;
+
+		case 0x0018:
+			swap_flag(&((struct colorlist_packed_flag*)data)->flag);
+			swap_colorlist_packed(&((struct colorlist_packed_flag*)data)->list);
+			break;
+	}
+}
+
+static
+void
+swap_anim_list(struct anim *item)
+{
+	for ( ; (uint8_t*)(item + 1) <= host.scene + host.scene_sz; ++item)
+	{
+		void *data;
+
+		swap16(&item->type);
+		swap32(&item->data);
+
+		data = scene_ptr(item->data);
+		if (data && swap_once((uint8_t*)data - host.scene))
+			swap_anim_data(item->type, data);
+
+		if (item->seg <= 0)
+			break;
+	}
+}
+
+static
+void
+swap_header(uint32_t *header)
+{
+	if (!swap_once((uint8_t*)header - host.scene))
+		return;
+
+	for ( ; (uint8_t*)(header + 2) <= host.scene + host.scene_sz; header += 2)
+	{
+		uint32_t cmd;
+
+		swap32(&header[0]);
+		swap32(&header[1]);
+		cmd = header[0] >> 24;
+
+		/* animated texture list */
+		if (cmd == 0x1A && scene_ptr(header[1]))
+			swap_anim_list(scene_ptr(header[1]));
+
+		/* alternate headers; the list length is not stored, *
+		 * so swap words that look like scene pointers        */
+		if (cmd == 0x18 && scene_ptr(header[1]))
+		{
+			uint32_t *list = scene_ptr(header[1]);
+			int i;
+
+			for (i = 0; i < 0x40; ++i)
+			{
+				uint32_t addr;
+
+				swap32(&list[i]);
+				addr = list[i];
+				if (addr && !scene_ptr(addr))
+				{
+					swap32(&list[i]);
+					break;
+				}
+				if (addr)
+					swap_header(scene_ptr(addr));
+			}
+		}
+
+		if (cmd == 0x14)
+			break;
+	}
+}
+
+/*
+ *
+ * z64ovl stand-ins
+ *
+ */
+
+void *
+graph_alloc(z64_gfx_t *gfx, uint32_t size)
+{
+	z64_disp_buf_t *buf = &gfx->poly_opa;
+
+	/* the game allocates from the tail of poly_opa, 16-byte-aligned */
+	size = (size + 15) & ~15;
+	buf->d = (Gfx*)((uint8_t*)buf->d - size);
+	host.graph_allocs += 1;
+
+	if (buf->d < buf->p)
+	{
+		fprintf(stderr, "graph memory exhausted\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return buf->d;
+}
+
+/* the zelda arena; blocks are mapped one by one, each preceded *
+ * by its size, so a limit on bytes in use can be simulated     */
+void *
+zelda_malloc(uint32_t size)
+{
+	uint8_t *p;
+
+	if (host.heap_max && host.heap_used + size > host.heap_max)
+		return 0;
+
+	p = low_alloc(size + 16);
+	*(uint32_t*)p = size;
+	host.heap_used += size;
+
+	return p + 16;
+}
+
+void
+zelda_free(void *ptr)
+{
+	uint8_t *p = (uint8_t*)ptr - 16;
+	uint32_t size;
+
+	if (!ptr)
+		return;
+
+	size = *(uint32_t*)p;
+	host.heap_used -= size;
+	munmap(p, size + 16);
+}
+
+void *
+zh_seg2ram(uint32_t addr)
+{
+	switch (addr >> 24)
+	{
+		case 0x02: return host.scene + (addr & 0xFFFFFF);
+		case 0x03: return host.room + (addr & 0xFFFFFF);
+	}
+
+	return (void*)(uintptr_t)addr;
+}
+
+int flag_get_roomclear(z64_global_t *gl, int flag) { return host.flags_on; }
+int flag_get_treasure(z64_global_t *gl, int flag) { return host.flags_on; }
+int flag_get_uscene(z64_global_t *gl, int flag) { return host.flags_on; }
+int temp_clear_flag_get(z64_global_t *gl, int flag) { return host.flags_on; }
+int flag_get_scenecollect(z64_global_t *gl, int flag) { return host.flags_on; }
+int flag_get_switch(z64_global_t *gl, int flag) { return host.flags_on; }
+int flag_get_event_chk_inf(int flag) { return host.flags_on; }
+int flag_get_inf_table(int flag) { return host.flags_on; }
+
+f32 Math_Coss(s16 angle) { return cosf(angle * (M_PI / 0x8000)); }
+f32 Math_Sins(s16 angle) { return sinf(angle * (M_PI / 0x8000)); }
+
+void zh_text_init(z64_global_t *gl, uint32_t color, int x, int y) { }
+void zh_text_draw(const char *fmt, ...) { }
+void zh_text_done(void) { }
+
+void z_debug_graph_alloc(Gfx *todo, z64_gfx_t *gfx, const char *file, int line) { }
+void z_debug_graph_write(Gfx *todo, z64_gfx_t *gfx, const char *file, int line) { }
+
+/* camera effects write no display lists, so what they are *
+ * asked to do is digested instead                          */
+static void digest_u32(uint32_t v);
+
+static
+void
+digest_f32(f32 v)
+{
+	uint32_t u;
+
+	memcpy(&u, &v, sizeof(u));
+	digest_u32(u);
+}
+
+void
+external_func_800AA76C(void *view, f32 arg1, f32 arg2, f32 arg3)
+{
+	digest_u32(0x800AA76C);
+	digest_f32(arg1);
+	digest_f32(arg2);
+	digest_f32(arg3);
+}
+
+void
+external_func_800AA78C(void *view, f32 arg1, f32 arg2, f32 arg3)
+{
+	digest_u32(0x800AA78C);
+	digest_f32(arg1);
+	digest_f32(arg2);
+	digest_f32(arg3);
+}
+
+void
+external_func_800AA7AC(void *view, f32 arg1)
+{
+	digest_u32(0x800AA7AC);
+	digest_f32(arg1);
+}
+
+s32 FrameAdvance_IsEnabled(z64_global_t *gl) { return 0; }
+
+void
+external_func_8009BEEC(z64_global_t *gl)
+{
+	digest_u32(0x8009BEEC);
+}
+
+/*
+ *
+ * measurement
+ *
+ */
+
+static
+uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void
+z64host_bench_begin(int type)
+{
+	clock_gettime(CLOCK_MONOTONIC, &host.handler_start);
+}
+
+void
+z64host_bench_end(int type)
+{
+	struct timespec ts;
+	uint64_t ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ns = (ts.tv_sec - host.handler_start.tv_sec) * 1000000000ull;
+	ns += ts.tv_nsec - host.handler_start.tv_nsec;
+
+	if (type < 0 || type >= HANDLER_MAX)
+		type = HANDLER_MAX - 1;
+	host.handler_ns[type] += ns;
+	host.handler_calls[type] += 1;
+}
+
+void
+z64host_diag(const char *fmt, ...)
+{
+	va_list ap;
+
+	fprintf(stderr, "z64scene: ");
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+}
+
+static
+void
+digest_u32(uint32_t v)
+{
+	int i;
+
+	/* FNV-1a */
+	for (i = 0; i < 4; ++i, v >>= 8)
+	{
+		host.digest ^= v & 0xFF;
+		host.digest *= 0x100000001B3ull;
+	}
+}
+
+/* digest a display list by content, following any pointers into *
+ * it, so that where things get allocated does not matter; with  *
+ * -d, the display list is printed as well                       */
+static
+void
+digest_dl(const Gfx *dl, int max, int depth)
+{
+	const uint8_t *graph_end = host.graph + host.graph_sz;
+
+	for ( ; max; ++dl, --max)
+	{
+		int op = dl->w0 >> 24;
+
+		if (host.dump)
+			printf("%*s%08X %08X\n", depth * 2 + 2, "", dl->w0, dl->w1);
+
+		digest_u32(dl->w0);
+
+		if (op == G_DL
+			|| op == G_SETTIMG
+			|| (op == G_MOVEWORD && ((dl->w0 >> 16) & 0xFF) == G_MW_SEGMENT)
+		)
+		{
+			uint8_t *p = (void*)(uintptr_t)dl->w1;
+
+			uint32_t seg = 0;
+
+			if (p >= host.scene && p < host.scene + host.scene_sz)
+				seg = 0x02000000 | (p - host.scene);
+			else if (p >= host.room && p < host.room + host.room_sz)
+				seg = 0x03000000 | (p - host.room);
+
+			if (seg)
+			{
+				if (host.dump)
+					printf("%*s-> %08X\n", depth * 2 + 4, "", seg);
+				digest_u32(seg);
+			}
+			else if (op == G_SETTIMG)
+				digest_u32(dl->w1);
+			else if (p >= host.graph && p < graph_end)
+				digest_dl((void*)p, (graph_end - p) / sizeof(*dl), depth + 1);
+			else if (p >= (uint8_t*)__executable_start && p < (uint8_t*)end)
+				digest_dl((void*)p, sizeof(Mtx) / sizeof(*dl), depth + 1); /* overlay data: lists, matrices */
+			else if (p)
+				digest_dl((void*)p, 32, depth + 1); /* heap data */
+			else
+				digest_u32(0);
+		}
+		else
+			digest_u32(dl->w1);
+
+		if (op == G_ENDDL)
+			break;
+	}
+}
+
+static
+void
+frame_begin(void)
+{
+	z64_disp_buf_t *b[] = {
+		&host.gfx.overlay
+		, &host.gfx.poly_opa
+		, &host.gfx.poly_xlu
+		, &host.gfx.work
+	};
+	int i;
+
+	for (i = 0; i < 4; ++i)
+	{
+		b[i]->p = b[i]->buf;
+		b[i]->d = (Gfx*)((uint8_t*)b[i]->buf + b[i]->size);
+	}
+
+	host.graph_allocs = 0;
+}
+
+static
+void
+usage(const char *exe)
+{
+	fprintf(stderr, "usage: %s [options] scene.zscene [room.zmap]\n", exe);
+	fprintf(stderr, "  -n frames    number of frames to replay (default 10000)\n");
+	fprintf(stderr, "  -p period    frames between flag toggles (default 100)\n");
+	fprintf(stderr, "  -s period    frames between switching scene setups 0 and 1\n");
+	fprintf(stderr, "  -r period    frames between moving the room to another buffer\n");
+	fprintf(stderr, "  -m bytes     zelda arena bytes available (default no limit)\n");
+	fprintf(stderr, "  -v           print statistics for every frame\n");
+	fprintf(stderr, "  -d           print display lists for every frame\n");
+	fprintf(stderr, "  -e digest    fail unless the digest printed matches this one\n");
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static z64_global_t gl;
+	const char *scene_fn = 0;
+	const char *room_fn = 0;
+	uint64_t frame_min = -1;
+	uint64_t frame_max = 0;
+	uint64_t frame_total = 0;
+	uint64_t bytes_opa = 0;
+	uint64_t bytes_xlu = 0;
+	uint64_t bytes_graph = 0;
+	uint64_t allocs = 0;
+	uint64_t handler_total = 0;
+	int frames = 10000;
+	int period = 100;
+	int setup_period = 0;
+	int room_period = 0;
+	int verbose = 0;
+	const char *expect = 0;
+	int i;
+
+	for (i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-p") && i + 1 < argc)
+			period = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			setup_period = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+			room_period = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+			host.heap_max = strtoul(argv[++i], 0, 0);
+		else if (!strcmp(argv[i], "-v"))
+			verbose = 1;
+		else if (!strcmp(argv[i], "-d"))
+			host.dump = 1;
+		else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+			expect = argv[++i];
+		else if (*argv[i] == '-')
+			usage(argv[0]);
+		else if (!scene_fn)
+			scene_fn = argv[i];
+		else if (!room_fn)
+			room_fn = argv[i];
+		else
+			usage(argv[0]);
+	}
+
+	if (!scene_fn || frames <= 0 || period <= 0 || setup_period < 0 || room_period < 0)
+		usage(argv[0]);
+
+	/* load files */
+	host.scene = file_load(scene_fn, &host.scene_sz);
+	if (room_fn)
+	{
+		host.room = file_load(room_fn, &host.room_sz);
+
+		/* a second copy, as if loaded into the other room buffer */
+		host.room_slot[0] = host.room;
+		host.room_slot[1] = low_alloc(host.room_sz + 16);
+		memcpy(host.room_slot[1], host.room, host.room_sz);
+	}
+	swapped = calloc(host.scene_sz, 1);
+	swap_header((uint32_t*)host.scene);
+
+	/* the overlay must never write to loaded files */
+	mprotect(host.scene, host.scene_sz + 16, PROT_READ);
+	if (host.room)
+	{
+		mprotect(host.room_slot[0], host.room_sz + 16, PROT_READ);
+		mprotect(host.room_slot[1], host.room_sz + 16, PROT_READ);
+	}
+
+	/* display buffers */
+	host.graph_sz = 4 * GRAPH_SIZE;
+	host.graph = low_alloc(host.graph_sz);
+	host.gfx.overlay.buf  = (Gfx*)(host.graph + 0 * GRAPH_SIZE);
+	host.gfx.poly_opa.buf = (Gfx*)(host.graph + 1 * GRAPH_SIZE);
+	host.gfx.poly_xlu.buf = (Gfx*)(host.graph + 2 * GRAPH_SIZE);
+	host.gfx.work.buf     = (Gfx*)(host.graph + 3 * GRAPH_SIZE);
+	host.gfx.overlay.size = host.gfx.poly_opa.size = GRAPH_SIZE;
+	host.gfx.poly_xlu.size = host.gfx.work.size = GRAPH_SIZE;
+
+	gl.common.gfx_ctxt = &host.gfx;
+	gl.scene_file = host.scene;
+	gl.scene_index = 0;
+	host.digest = 0xCBF29CE484222325ull;
+
+	for (i = 0; i < frames; ++i)
+	{
+		uint64_t start;
+		uint64_t ns;
+		uint32_t opa;
+		uint32_t xlu;
+		uint32_t graph;
+
+		host.flags_on = (i / period) & 1;
+		z64_host_is_night = host.flags_on;
+		if (setup_period)
+			z64_host_save.scene_setup_index = (i / setup_period) & 1;
+		if (room_period && host.room)
+			host.room = host.room_slot[(i / room_period) & 1];
+		gl.gameplay_frames = i;
+		frame_begin();
+
+		start = now_ns();
+		z64scene_main(&gl);
+		ns = now_ns() - start;
+
+		opa = (host.gfx.poly_opa.p - host.gfx.poly_opa.buf) * sizeof(Gfx);
+		xlu = (host.gfx.poly_xlu.p - host.gfx.poly_xlu.buf) * sizeof(Gfx);
+		graph = (uint8_t*)host.gfx.poly_opa.buf + host.gfx.poly_opa.size
+			- (uint8_t*)host.gfx.poly_opa.d
+		;
+
+		if (host.dump)
+			printf("frame %d poly_opa:\n", i);
+		digest_dl(host.gfx.poly_opa.buf, opa / sizeof(Gfx), 0);
+		if (host.dump)
+			printf("frame %d poly_xlu:\n", i);
+		digest_dl(host.gfx.poly_xlu.buf, xlu / sizeof(Gfx), 0);
+
+		if (verbose)
+			printf(
+				"frame %6d: %8llu ns, opa %4u, xlu %4u, graph %5u bytes"
+				" (%u allocs)\n"
+				, i, (unsigned long long)ns, opa, xlu, graph
+				, host.graph_allocs
+			);
+
+		/* the first frame parses the scene; keep it out of the stats */
+		if (i == 0 && frames > 1)
+		{
+			memset(host.handler_ns, 0, sizeof(host.handler_ns));
+			memset(host.handler_calls, 0, sizeof(host.handler_calls));
+			printf("first frame (includes scene load): %llu ns\n", (unsigned long long)ns);
+			continue;
+		}
+
+		frame_total += ns;
+		frame_min = ns < frame_min ? ns : frame_min;
+		frame_max = ns > frame_max ? ns : frame_max;
+		bytes_opa += opa;
+		bytes_xlu += xlu;
+		bytes_graph += graph;
+		allocs += host.graph_allocs;
+	}
+
+	if (frames > 1)
+		frames -= 1;
+
+	printf("%s: %d frames\n", scene_fn, frames);
+	printf(
+		"frame time (ns): min %llu, avg %llu, max %llu\n"
+		, (unsigned long long)frame_min
+		, (unsigned long long)(frame_total / frames)
+		, (unsigned long long)frame_max
+	);
+
+	printf("handler    calls/frame    ns/call    ns/frame\n");
+	for (i = 0; i < HANDLER_MAX; ++i)
+	{
+		if (!host.handler_calls[i])
+			continue;
+
+		handler_total += host.handler_ns[i];
+		printf(
+			"0x%04X  %12.2f %10llu %11llu\n"
+			, i
+			, (double)host.handler_calls[i] / frames
+			, (unsigned long long)(host.handler_ns[i] / host.handler_calls[i])
+			, (unsigned long long)(host.handler_ns[i] / frames)
+		);
+	}
+	printf("all     %35llu\n", (unsigned long long)(handler_total / frames));
+
+	printf(
+		"display list bytes/frame: poly_opa %llu, poly_xlu %llu, graph %llu"
+		" (%.2f graph_alloc calls)\n"
+		, (unsigned long long)(bytes_opa / frames)
+		, (unsigned long long)(bytes_xlu / frames)
+		, (unsigned long long)(bytes_graph / frames)
+		, (double)allocs / frames
+	);
+	printf("digest: %016llx\n", (unsigned long long)host.digest);
+
+	/* fixtures (see `make bench`) are checked against known output */
+	if (expect && strtoull(expect, 0, 16) != host.digest)
+	{
+		fprintf(stderr, "%s: digest differs from %s\n", scene_fn, expect);
+		return EXIT_FAILURE;
+	}
+
+	return 0;
+}
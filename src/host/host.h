@@ -0,0 +1,293 @@
+/****************************************************
+ * <z64.me> host.h - stand-ins for z64ovl, so that  *
+ *          z64scene.c can be built and measured on *
+ *          a desktop machine (see bench.c)         *
+ ****************************************************/
+
+#ifndef Z64SCENE_HOST_H_INCLUDED
+#define Z64SCENE_HOST_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* NOTE: pointers end up inside 32-bit display list words and *
+ *       scene structures, exactly as they would on the N64; *
+ *       bench.c keeps every such pointer below 4 GiB (the    *
+ *       binary is linked -no-pie, and buffers use MAP_32BIT) */
+
+typedef int8_t    s8;
+typedef uint8_t   u8;
+typedef int16_t   s16;
+typedef uint16_t  u16;
+typedef int32_t   s32;
+typedef uint32_t  u32;
+typedef int64_t   s64;
+typedef uint64_t  u64;
+typedef float     f32;
+
+/* access helpers */
+#define AADDR(a, o)           ((void*)((uint8_t*)(a) + (o)))
+#define AVAL(base, type, o)   (*(type*)((uint8_t*)(base) + (o)))
+
+/*
+ *
+ * display lists (F3DZEX2 encodings of the opcodes z64scene uses)
+ *
+ */
+
+typedef struct
+{
+	uint32_t  w0;
+	uint32_t  w1;
+} Gfx;
+
+typedef struct
+{
+	int32_t   m[4][4];
+} Mtx;
+
+#define G_NOOP             0x00
+#define G_MTX              0xDA
+#define G_MOVEWORD         0xDB
+#define G_DL               0xDE
+#define G_ENDDL            0xDF
+#define G_RDPLOADSYNC      0xE6
+#define G_RDPPIPESYNC      0xE7
+#define G_RDPTILESYNC      0xE8
+#define G_LOADTLUT         0xF0
+#define G_SETTILESIZE      0xF2
+#define G_SETTILE          0xF5
+#define G_SETPRIMCOLOR     0xFA
+#define G_SETENVCOLOR      0xFB
+#define G_SETTIMG          0xFD
+#define G_MW_SEGMENT       0x06
+
+#define G_IM_FMT_RGBA      0
+#define G_IM_SIZ_16b       2
+#define G_TX_LOADTILE      7
+
+#define G_HOST_PTR(p)      ((uint32_t)(uintptr_t)(p))
+#define G_HOST_RGBA(r, g, b, a) (            \
+	  ((uint32_t)((r) & 0xFF) << 24)         \
+	| ((uint32_t)((g) & 0xFF) << 16)         \
+	| ((uint32_t)((b) & 0xFF) <<  8)         \
+	| ((uint32_t)((a) & 0xFF)      )         \
+)
+
+#define gHostCmd(pkt, c0, c1)                \
+	do {                                      \
+		Gfx *_g = (Gfx*)(pkt);                 \
+		_g->w0 = (c0);                         \
+		_g->w1 = (c1);                         \
+	} while (0)
+
+#define gsDPNoOp()                           \
+	{ G_NOOP << 24, 0 }
+
+#define gsSPEndDisplayList()                 \
+	{ G_ENDDL << 24, 0 }
+
+#define gDPNoOp(pkt)                         \
+	gHostCmd(pkt, G_NOOP << 24, 0)
+
+#define gSPEndDisplayList(pkt)               \
+	gHostCmd(pkt, G_ENDDL << 24, 0)
+
+#define gSPDisplayList(pkt, dl)              \
+	gHostCmd(pkt, G_DL << 24, G_HOST_PTR(dl))
+
+#define gSPSegment(pkt, seg, base)           \
+	gHostCmd(                                 \
+		pkt                                    \
+		, (G_MOVEWORD << 24)                   \
+		| (G_MW_SEGMENT << 16)                 \
+		| (((seg) * 4) & 0xFFFF)               \
+		, G_HOST_PTR(base)                     \
+	)
+
+#define gDPPipeSync(pkt)                     \
+	gHostCmd(pkt, G_RDPPIPESYNC << 24, 0)
+
+#define gDPTileSync(pkt)                     \
+	gHostCmd(pkt, G_RDPTILESYNC << 24, 0)
+
+#define gDPSetEnvColor(pkt, r, g, b, a)      \
+	gHostCmd(pkt, G_SETENVCOLOR << 24, G_HOST_RGBA(r, g, b, a))
+
+#define gDPSetPrimColor(pkt, m, l, r, g, b, a) \
+	gHostCmd(                                 \
+		pkt                                    \
+		, (G_SETPRIMCOLOR << 24)               \
+		| (((m) & 0xFF) << 8)                  \
+		| ((l) & 0xFF)                         \
+		, G_HOST_RGBA(r, g, b, a)              \
+	)
+
+#define gDPLoadSync(pkt)                     \
+	gHostCmd(pkt, G_RDPLOADSYNC << 24, 0)
+
+#define gDPSetTextureImage(pkt, f, s, w, i)  \
+	gHostCmd(                                 \
+		pkt                                    \
+		, (G_SETTIMG << 24)                    \
+		| (((f) & 0x7) << 21)                  \
+		| (((s) & 0x3) << 19)                  \
+		| (((w) - 1) & 0xFFF)                  \
+		, G_HOST_PTR(i)                        \
+	)
+
+/* the clamp, mirror, mask and shift fields are not used here */
+#define gDPSetTile(pkt, f, s, line, tmem, tile, pal, cmt, maskt, shiftt, cms, masks, shifts) \
+	gHostCmd(                                 \
+		pkt                                    \
+		, (G_SETTILE << 24)                    \
+		| (((f) & 0x7) << 21)                  \
+		| (((s) & 0x3) << 19)                  \
+		| (((line) & 0x1FF) << 9)              \
+		| ((tmem) & 0x1FF)                     \
+		, (((tile) & 0x7) << 24)               \
+		| (((pal) & 0xF) << 20)                \
+	)
+
+#define gDPLoadTLUTCmd(pkt, tile, count)     \
+	gHostCmd(                                 \
+		pkt                                    \
+		, G_LOADTLUT << 24                     \
+		, (((tile) & 0x7) << 24)               \
+		| (((count) & 0x3FF) << 14)            \
+	)
+
+#define gDPLoadTLUT(pkt, count, tmemaddr, dram) \
+	do {                                      \
+		gDPSetTextureImage(pkt, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, dram); \
+		gDPTileSync(pkt);                      \
+		gDPSetTile(pkt, 0, 0, 0, tmemaddr, G_TX_LOADTILE, 0, 0, 0, 0, 0, 0, 0); \
+		gDPLoadSync(pkt);                      \
+		gDPLoadTLUTCmd(pkt, G_TX_LOADTILE, (count) - 1); \
+		gDPPipeSync(pkt);                      \
+	} while (0)
+
+#define gDPSetTileSize(pkt, t, uls, ult, lrs, lrt) \
+	gHostCmd(                                 \
+		pkt                                    \
+		, (G_SETTILESIZE << 24)                \
+		| (((uint32_t)(uls) & 0xFFF) << 12)    \
+		| ((uint32_t)(ult) & 0xFFF)            \
+		, (((uint32_t)(t) & 0x7) << 24)        \
+		| (((uint32_t)(lrs) & 0xFFF) << 12)    \
+		| ((uint32_t)(lrt) & 0xFFF)            \
+	)
+
+/*
+ *
+ * game state
+ *
+ */
+
+typedef struct
+{
+	uint32_t  size;
+	Gfx      *buf;
+	Gfx      *p;   /* head (commands) */
+	Gfx      *d;   /* tail (graph_alloc) */
+} z64_disp_buf_t;
+
+typedef struct
+{
+	z64_disp_buf_t  overlay;
+	z64_disp_buf_t  poly_opa;
+	z64_disp_buf_t  poly_xlu;
+	z64_disp_buf_t  work;
+} z64_gfx_t;
+
+typedef struct
+{
+	z64_gfx_t      *gfx_ctxt;
+} z64_ctxt_t;
+
+typedef struct
+{
+	uint8_t         raw[0x128];
+} z64_view_t;
+
+typedef struct
+{
+	z64_ctxt_t      common;
+	uint16_t        scene_index;
+	void           *scene_file;
+	uint32_t        gameplay_frames;
+	z64_view_t      view;
+
+	/* FLAG_TYPE_GLOBAL may address anything in here */
+	uint8_t         raw[0x12600];
+} z64_global_t;
+
+typedef struct
+{
+	uint32_t        scene_setup_index;
+
+	/* FLAG_TYPE_SAVE may address anything in here */
+	uint8_t         raw[0x1500];
+} z64_save_context_t;
+
+extern z64_save_context_t z64_host_save;
+extern uint32_t z64_host_is_night;
+
+#define Z64GL_SAVE_CONTEXT   (&z64_host_save)
+#define Z64GL_IS_NIGHT       (&z64_host_is_night)
+
+/*
+ *
+ * game functions (implemented in bench.c)
+ *
+ */
+
+void *graph_alloc(z64_gfx_t *gfx, uint32_t size);
+void *zelda_malloc(uint32_t size);
+void zelda_free(void *ptr);
+void *zh_seg2ram(uint32_t addr);
+
+int flag_get_roomclear(z64_global_t *gl, int flag);
+int flag_get_treasure(z64_global_t *gl, int flag);
+int flag_get_uscene(z64_global_t *gl, int flag);
+int temp_clear_flag_get(z64_global_t *gl, int flag);
+int flag_get_scenecollect(z64_global_t *gl, int flag);
+int flag_get_switch(z64_global_t *gl, int flag);
+int flag_get_event_chk_inf(int flag);
+int flag_get_inf_table(int flag);
+
+f32 Math_Coss(s16 angle);
+f32 Math_Sins(s16 angle);
+
+void zh_text_init(z64_global_t *gl, uint32_t color, int x, int y);
+void zh_text_draw(const char *fmt, ...);
+void zh_text_done(void);
+
+void z_debug_graph_alloc(Gfx *todo, z64_gfx_t *gfx, const char *file, int line);
+void z_debug_graph_write(Gfx *todo, z64_gfx_t *gfx, const char *file, int line);
+
+void external_func_800AA76C(void *view, f32 arg1, f32 arg2, f32 arg3);
+void external_func_800AA78C(void *view, f32 arg1, f32 arg2, f32 arg3);
+void external_func_800AA7AC(void *view, f32 arg1);
+s32 FrameAdvance_IsEnabled(z64_global_t *gl);
+void external_func_8009BEEC(z64_global_t *gl);
+
+/*
+ *
+ * benchmark hooks (z64scene.c defines these away on the N64)
+ *
+ */
+
+void z64host_bench_begin(int type);
+void z64host_bench_end(int type);
+
+#define bench_begin(type)   z64host_bench_begin(type)
+#define bench_end(type)     z64host_bench_end(type)
+
+/* reports what z64scene.c could not compile, on stderr */
+void z64host_diag(const char *fmt, ...);
+
+#define diag(...)           z64host_diag(__VA_ARGS__)
+
+#endif /* Z64SCENE_HOST_H_INCLUDED */
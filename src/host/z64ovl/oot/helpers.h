@@ -0,0 +1,2 @@
+/* host build: everything z64scene.c needs lives in host.h */
+#include <host.h>
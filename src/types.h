@@ -58,6 +58,30 @@ struct scroll_flag
 	struct flag       flag;   /* flag structure    */
 };
 
+/* one tile of a batched scroll */
+struct scroll_tile
+{
+	uint8_t           tile;   /* tile descriptor   */
+	int8_t            u;      /* u speed           */
+	int8_t            v;      /* v speed           */
+	uint8_t           w;      /* texture w         */
+	uint8_t           h;      /* texture h         */
+};
+
+/* data processed by scroll_tiles functions */
+struct scroll_tiles
+{
+	uint16_t           num;     /* number of tiles   */
+	struct scroll_tile tile[1]; /* num long          */
+};
+
+/* data processed by scroll_tiles functions (flag) */
+struct scroll_tiles_flag
+{
+	struct flag         flag; /* flag structure    */
+	struct scroll_tiles list; /* tiles             */
+};
+
 enum colorkey_types
 {
 	COLORKEY_PRIM       = 1 << 0
@@ -71,6 +95,13 @@ enum ease
 	EASE_LINEAR = 0           /* linear            */
 	, EASE_SIN_IN             /* sinusoidal (in)   */
 	, EASE_SIN_OUT            /* sinusoidal (out)  */
+	, EASE_QUAD_IN            /* quadratic (in)    */
+	, EASE_QUAD_OUT           /* quadratic (out)   */
+	, EASE_CUBIC_IN           /* cubic (in)        */
+	, EASE_CUBIC_OUT          /* cubic (out)       */
+	, EASE_STEP               /* hold previous key */
+	
+	/* NOTE: only add new types to the end of the list */
 };
 
 /* substructure used to describe color keyframe */
@@ -99,6 +130,34 @@ struct colorlist_flag
 
 };
 
+/* color list, packed; only channels named in `which` are stored */
+struct colorlist_packed
+{
+	enum8(colorkey)   which;  /* units to compute  */
+	enum8(ease)       ease;   /* ease function     */
+	uint16_t          dur;    /* duration          */
+	uint16_t          num;    /* number of keys    */
+	uint16_t          colors; /* palette size; 0 = no palette */
+	uint8_t           data[1];/* palette, then keys */
+
+	/* NOTE: data[] begins with the palette: `colors` rgba colors, *
+	 *       4 bytes each; the keys follow, each one laid out as:  *
+	 *       uint8_t next;   frames til next key (1 - 255)         *
+	 *       prim (COLORKEY_PRIM): palette index (1 byte) if there *
+	 *                       is a palette, else rgba (4 bytes)     *
+	 *       env  (COLORKEY_ENV): as prim                          *
+	 *       uint8_t lfrac;  (COLORKEY_LODFRAC)                    *
+	 *       uint8_t mlevel; (COLORKEY_MINLEVEL)                   *
+	 *       channels not named in `which` are taken to be 0; see *
+	 *       src/util/colorpack.c for an encoder                   */
+};
+
+struct colorlist_packed_flag
+{
+	struct flag             flag; /* flag structure  */
+	struct colorlist_packed list; /* color structure */
+};
+
 /* pointer loop */
 struct pointer_loop
 {
@@ -144,13 +203,55 @@ struct pointer_timeloop_flag
 	struct pointer_timeloop  list; /* list structure */
 };
 
+/* pointer loop; pointers are spaced evenly, as flipbook *
+ * frames laid out back to back are                       */
+struct pointer_stride
+{
+	uint32_t          base;   /* first pointer                   */
+	uint32_t          stride; /* bytes from one pointer to next  */
+	uint16_t          num;    /* number of pointers              */
+	uint16_t          each;   /* frames to display each pointer  */
+};
+
+/* pointer loop; pointers spaced evenly (flag) */
+struct pointer_stride_flag
+{
+	struct flag           flag; /* flag structure */
+	struct pointer_stride list; /* list structure */
+};
+
+/* palette loop; palettes are spaced evenly, and each one *
+ * is loaded into TMEM in turn                            */
+struct palette_loop
+{
+	uint32_t          base;   /* first palette                   */
+	uint32_t          stride; /* bytes from one palette to next  */
+	uint16_t          num;    /* number of palettes              */
+	uint16_t          each;   /* frames to display each palette  */
+	uint16_t          count;  /* colors (16 for CI4, 256 for CI8)*/
+	uint16_t          pal;    /* CI4 palette slot (0 for CI8)    */
+};
+
+/* flipbook whose frames are stacked in one texture (an atlas *
+ * strip), loaded once; each frame has its own time            */
+struct atlas_timeloop
+{
+	uint8_t           tile;   /* tile descriptor                 */
+	uint8_t           pad;    /* unused; padding                 */
+	uint8_t           w;      /* frame width (texels)            */
+	uint8_t           h;      /* frame height (texels)           */
+	uint16_t          num;    /* number of entries in each[]     */
+	uint16_t          each[1];/* first frame of each texture frame;
+	                           * the last entry is the end frame  */
+};
+
 /* animation settings; pointed to by 0x1A scene header command */
 struct anim
 {
 	int8_t            seg;    /* ram segment       */
-	uint8_t           pad;    /* unused            */
+	uint8_t           every;  /* update interval (frames; 0 = 1) */
 	uint16_t          type;   /* function          */
-	void             *data;   /* data              */
+	uint32_t          data;   /* data (pointer)    */
 };
 
 struct cameraeffect
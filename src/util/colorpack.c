@@ -0,0 +1,254 @@
+/******************************************************
+ * <z64.me> colorpack.c - pack color lists for 0x0017 *
+ ******************************************************/
+
+/* reads a color list (struct colorlist, big-endian, as used by *
+ * 0x0009) and writes it packed (struct colorlist_packed, as    *
+ * used by 0x0017): only channels named in `which` are kept,    *
+ * durations are stored in one byte each, and colors are moved  *
+ * into a shared palette when doing so makes the list smaller   */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* from `enum colorkey_types` in types.h */
+#define COLORKEY_PRIM      (1 << 0)
+#define COLORKEY_ENV       (1 << 1)
+#define COLORKEY_LODFRAC   (1 << 2)
+#define COLORKEY_MINLEVEL  (1 << 3)
+
+#define KEY_SIZE   12   /* sizeof(struct colorkey)  */
+#define HEAD_SIZE   4   /* which, ease, dur         */
+#define MAX_COLORS 256  /* palette indices are 8-bit */
+
+static
+unsigned int
+u32(unsigned char *b)
+{
+	return (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+}
+
+static
+unsigned int
+u16(unsigned char *b)
+{
+	return (b[0] << 8) | b[1];
+}
+
+static
+void
+put16(unsigned char *b, unsigned int v)
+{
+	b[0] = v >> 8;
+	b[1] = v;
+}
+
+static
+void
+put32(unsigned char *b, unsigned int v)
+{
+	b[0] = v >> 24;
+	b[1] = v >> 16;
+	b[2] = v >> 8;
+	b[3] = v;
+}
+
+/* returns index of color in palette, adding it if it is new; *
+ * -1 if the palette is full                                  */
+static
+int
+palette_index(unsigned int *pal, int *num, unsigned int color)
+{
+	int i;
+
+	for (i = 0; i < *num; ++i)
+		if (pal[i] == color)
+			return i;
+
+	if (*num >= MAX_COLORS)
+		return -1;
+
+	pal[*num] = color;
+	return (*num)++;
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned int pal[MAX_COLORS];
+	unsigned char *raw;
+	unsigned char *list;
+	unsigned char *out;
+	unsigned char *dst;
+	unsigned int ofs = 0;
+	unsigned int sz;
+	int which;
+	int channels;
+	int colors = 0;
+	int palsize;
+	int rawsize;
+	int outsize;
+	int num;
+	int i;
+	FILE *fp;
+
+	if (argc < 3 || argc > 4)
+	{
+		fprintf(stderr, "usage: colorpack in.bin out.bin [offset]\n");
+		fprintf(stderr, "  packs the color list at hexadecimal offset\n");
+		fprintf(stderr, "  within in.bin (0 if omitted) into out.bin\n");
+		return EXIT_FAILURE;
+	}
+
+	if (argc == 4 && sscanf(argv[3], "%X", &ofs) != 1)
+	{
+		fprintf(stderr, "failed to read hexadecimal offset '%s'\n", argv[3]);
+		return EXIT_FAILURE;
+	}
+
+	/* read input file */
+	fp = fopen(argv[1], "rb");
+	if (!fp)
+	{
+		fprintf(stderr, "failed to open '%s' for reading\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fseek(fp, 0, SEEK_END);
+	sz = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	raw = malloc(sz + 1);
+	if (!raw || fread(raw, 1, sz, fp) != sz)
+	{
+		fprintf(stderr, "failed to read '%s'\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fclose(fp);
+
+	if (ofs + HEAD_SIZE > sz)
+	{
+		fprintf(stderr, "offset 0x%X exceeds file size 0x%X\n", ofs, sz);
+		return EXIT_FAILURE;
+	}
+	list = raw + ofs;
+	which = list[0];
+
+	/* count keys; the last (next == 0) only terminates the list */
+	for (num = 0; ; ++num)
+	{
+		unsigned char *key = list + HEAD_SIZE + num * KEY_SIZE;
+		unsigned int next;
+
+		if (key + KEY_SIZE > raw + sz)
+		{
+			fprintf(stderr, "color list runs past end of file\n");
+			return EXIT_FAILURE;
+		}
+
+		next = u16(key + 10);
+		if (!next)
+			break;
+
+		if (next > 0xFF)
+		{
+			fprintf(stderr, "key %d lasts %d frames (255 at most)\n", num, next);
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* try a palette of every color used */
+	channels = !!(which & COLORKEY_PRIM) + !!(which & COLORKEY_ENV);
+	for (i = 0; i < num && colors >= 0; ++i)
+	{
+		unsigned char *key = list + HEAD_SIZE + i * KEY_SIZE;
+
+		if ((which & COLORKEY_PRIM) && palette_index(pal, &colors, u32(key)) < 0)
+			colors = -1;
+		if ((which & COLORKEY_ENV) && colors >= 0 && palette_index(pal, &colors, u32(key + 4)) < 0)
+			colors = -1;
+	}
+
+	/* use it only if the result is smaller */
+	rawsize = num * channels * 4;
+	palsize = colors * 4 + num * channels;
+	if (colors < 0 || palsize >= rawsize)
+		colors = 0;
+
+	outsize = 8 + (colors ? palsize : rawsize)
+		+ num * (1
+			+ !!(which & COLORKEY_LODFRAC)
+			+ !!(which & COLORKEY_MINLEVEL)
+		)
+	;
+	out = calloc(outsize, 1);
+	if (!out)
+	{
+		fprintf(stderr, "memory error\n");
+		return EXIT_FAILURE;
+	}
+
+	/* header */
+	out[0] = which;
+	out[1] = list[1];
+	put16(out + 2, u16(list + 2));
+	put16(out + 4, num);
+	put16(out + 6, colors);
+	dst = out + 8;
+
+	for (i = 0; i < colors; ++i, dst += 4)
+		put32(dst, pal[i]);
+
+	/* keys */
+	for (i = 0; i < num; ++i)
+	{
+		unsigned char *key = list + HEAD_SIZE + i * KEY_SIZE;
+		int k;
+
+		*dst++ = u16(key + 10);
+
+		for (k = 0; k < 2; ++k)
+		{
+			unsigned int color = u32(key + k * 4);
+
+			if (!(which & (k ? COLORKEY_ENV : COLORKEY_PRIM)))
+				continue;
+
+			if (colors)
+				*dst++ = palette_index(pal, &colors, color);
+			else
+			{
+				put32(dst, color);
+				dst += 4;
+			}
+		}
+
+		if (which & COLORKEY_LODFRAC)
+			*dst++ = key[8];
+
+		if (which & COLORKEY_MINLEVEL)
+			*dst++ = key[9];
+	}
+
+	/* write output file */
+	fp = fopen(argv[2], "wb");
+	if (!fp || fwrite(out, 1, outsize, fp) != (size_t)outsize)
+	{
+		fprintf(stderr, "failed to write '%s'\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	fclose(fp);
+
+	fprintf(
+		stderr
+		, "%d keys, %d colors in palette: 0x%X bytes -> 0x%X bytes\n"
+		, num
+		, colors
+		, HEAD_SIZE + (num + 1) * KEY_SIZE
+		, outsize
+	);
+
+	free(raw);
+	free(out);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+/****************************************************
+ * <z64.me> easegen.c - generate easing curve table *
+ ****************************************************/
+
+/* prints a C header containing one table per easing curve; each *
+ * table maps normalized progress through a color key (sampled   *
+ * EASE_STEPS times) to an 8.8 fixed-point blend factor, so that  *
+ * z64scene.c can ease colors without libm or division; it also  *
+ * prints the reciprocals color keys are timed with, for the same *
+ * reason                                                         */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define EASE_STEPS 64
+#define RECIP_NUM  256
+
+static double sin_in(double x)    { return 1 - cos(x * M_PI / 2); }
+static double sin_out(double x)   { return sin(x * M_PI / 2); }
+static double quad_in(double x)   { return x * x; }
+static double quad_out(double x)  { return 1 - (1 - x) * (1 - x); }
+static double cubic_in(double x)  { return x * x * x; }
+static double cubic_out(double x) { return 1 - (1 - x) * (1 - x) * (1 - x); }
+
+/* these must follow `enum ease` in types.h, from EASE_SIN_IN onward */
+static const struct
+{
+	const char *name;
+	double    (*curve)(double x);
+} curves[] = {
+	{ "EASE_SIN_IN", sin_in }
+	, { "EASE_SIN_OUT", sin_out }
+	, { "EASE_QUAD_IN", quad_in }
+	, { "EASE_QUAD_OUT", quad_out }
+	, { "EASE_CUBIC_IN", cubic_in }
+	, { "EASE_CUBIC_OUT", cubic_out }
+};
+
+int
+main(void)
+{
+	int i;
+	int k;
+	int num = sizeof(curves) / sizeof(*curves);
+
+	printf("/* generated by src/util/easegen.c; do not edit */\n\n");
+	printf("#ifndef Z64SCENE_EASE_H_INCLUDED\n");
+	printf("#define Z64SCENE_EASE_H_INCLUDED\n\n");
+	printf("#define EASE_STEPS  %d\n\n", EASE_STEPS);
+	printf("/* one row per curve, beginning with %s */\n", curves[0].name);
+	printf("static const uint16_t ease_table[][EASE_STEPS + 1] =\n{\n");
+
+	for (i = 0; i < num; ++i)
+	{
+		printf("\t%s/* %s */", i ? ", " : "", curves[i].name);
+
+		for (k = 0; k <= EASE_STEPS; ++k)
+		{
+			double y = curves[i].curve((double)k / EASE_STEPS);
+
+			printf("%s%s%3d", k % 13 ? "" : "\n\t\t", k ? ", " : "{ ", (int)lround(y * 0x100));
+		}
+
+		printf(" }\n");
+	}
+
+	printf("};\n\n");
+
+	/* (1 << 24) / n, rounded up, so that frame * recip >> 16 never *
+	 * falls short of the 0.8 fixed-point progress frame / n        */
+	printf("/* (1 << 24) / n, rounded up; index 0 is unused */\n");
+	printf("static const uint32_t recip_table[%d] =\n{", RECIP_NUM);
+
+	for (k = 0; k < RECIP_NUM; ++k)
+	{
+		unsigned long r = k ? ((1ul << 24) + k - 1) / k : 0;
+
+		printf("%s%s0x%07lX", k % 8 ? "" : "\n\t", k ? ", " : "  ", r);
+	}
+
+	printf("\n};\n\n");
+	printf("#endif /* Z64SCENE_EASE_H_INCLUDED */\n");
+
+	return 0;
+}
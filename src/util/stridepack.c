@@ -0,0 +1,186 @@
+/*********************************************************
+ * <z64.me> stridepack.c - pack pointer lists for 0x0011 *
+ *********************************************************/
+
+/* reads a pointer list (struct pointer_loop, big-endian, as used *
+ * by 0x000B) and writes it as evenly spaced pointers (struct     *
+ * pointer_stride, as used by 0x0011): the first pointer, the     *
+ * bytes between pointers, their count, and the frames each is    *
+ * shown; this only works if every pointer is the same distance   *
+ * past the one before it, as flipbook frames laid out back to    *
+ * back are, and every pointer is shown for the same time         */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HEAD_SIZE   8   /* dur, time, each, pad          */
+#define OUT_SIZE   12   /* sizeof(struct pointer_stride) */
+
+static
+unsigned int
+u32(unsigned char *b)
+{
+	return (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+}
+
+static
+unsigned int
+u16(unsigned char *b)
+{
+	return (b[0] << 8) | b[1];
+}
+
+static
+void
+put16(unsigned char *b, unsigned int v)
+{
+	b[0] = v >> 8;
+	b[1] = v;
+}
+
+static
+void
+put32(unsigned char *b, unsigned int v)
+{
+	b[0] = v >> 24;
+	b[1] = v >> 16;
+	b[2] = v >> 8;
+	b[3] = v;
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned char out[OUT_SIZE];
+	unsigned char *raw;
+	unsigned char *list;
+	unsigned int ofs = 0;
+	unsigned int sz;
+	unsigned int dur;
+	unsigned int each;
+	unsigned int base;
+	unsigned int stride = 0;
+	int num;
+	int i;
+	FILE *fp;
+
+	if (argc < 3 || argc > 4)
+	{
+		fprintf(stderr, "usage: stridepack in.bin out.bin [offset]\n");
+		fprintf(stderr, "  packs the pointer list at hexadecimal offset\n");
+		fprintf(stderr, "  within in.bin (0 if omitted) into out.bin;\n");
+		fprintf(stderr, "  for 0x000C, give the offset past the flag, and\n");
+		fprintf(stderr, "  keep the flag in front of the result (0x0012)\n");
+		return EXIT_FAILURE;
+	}
+
+	if (argc == 4 && sscanf(argv[3], "%X", &ofs) != 1)
+	{
+		fprintf(stderr, "failed to read hexadecimal offset '%s'\n", argv[3]);
+		return EXIT_FAILURE;
+	}
+
+	/* read input file */
+	fp = fopen(argv[1], "rb");
+	if (!fp)
+	{
+		fprintf(stderr, "failed to open '%s' for reading\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fseek(fp, 0, SEEK_END);
+	sz = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	raw = malloc(sz + 1);
+	if (!raw || fread(raw, 1, sz, fp) != sz)
+	{
+		fprintf(stderr, "failed to read '%s'\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fclose(fp);
+
+	if (ofs + HEAD_SIZE > sz)
+	{
+		fprintf(stderr, "offset 0x%X exceeds file size 0x%X\n", ofs, sz);
+		return EXIT_FAILURE;
+	}
+	list = raw + ofs;
+	dur = u16(list);
+	each = u16(list + 4);
+
+	/* 0x0011 shows every pointer for `each` frames, so the cycle *
+	 * must be a whole number of them                             */
+	if (!each || !dur || dur % each)
+	{
+		fprintf(
+			stderr
+			, "%d frames do not divide into pointers of %d frames\n"
+			, dur
+			, each
+		);
+		return EXIT_FAILURE;
+	}
+
+	/* 0x0011 starts every cycle at frame 0 */
+	if (u16(list + 2))
+	{
+		fprintf(stderr, "time is %d (0 expected)\n", u16(list + 2));
+		return EXIT_FAILURE;
+	}
+
+	num = dur / each;
+	if (ofs + HEAD_SIZE + num * 4 > sz)
+	{
+		fprintf(stderr, "pointer list runs past end of file\n");
+		return EXIT_FAILURE;
+	}
+
+	/* every pointer must follow the one before it by `stride` */
+	base = u32(list + HEAD_SIZE);
+	if (num > 1)
+		stride = u32(list + HEAD_SIZE + 4) - base;
+	for (i = 1; i < num; ++i)
+	{
+		unsigned int ptr = u32(list + HEAD_SIZE + i * 4);
+
+		if (ptr <= base || ptr - base != i * stride)
+		{
+			fprintf(
+				stderr
+				, "pointer %d (%08X) is not %08X + %d * 0x%X\n"
+				, i
+				, ptr
+				, base
+				, i
+				, stride
+			);
+			return EXIT_FAILURE;
+		}
+	}
+
+	put32(out, base);
+	put32(out + 4, stride);
+	put16(out + 8, num);
+	put16(out + 10, each);
+
+	/* write output file */
+	fp = fopen(argv[2], "wb");
+	if (!fp || fwrite(out, 1, OUT_SIZE, fp) != OUT_SIZE)
+	{
+		fprintf(stderr, "failed to write '%s'\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	fclose(fp);
+
+	fprintf(
+		stderr
+		, "%d pointers, 0x%X bytes apart: 0x%X bytes -> 0x%X bytes\n"
+		, num
+		, stride
+		, HEAD_SIZE + num * 4
+		, OUT_SIZE
+	);
+
+	free(raw);
+
+	return EXIT_SUCCESS;
+}
@@ -3,25 +3,418 @@
 #include <z64ovl/z64_functions.h>
 
 #include "types.h"
+#include "ease.h"  /* generated by src/util/easegen.c */
 
+/* per-handler timing hooks; only the host benchmark defines these */
+#ifndef bench_begin
+#	define bench_begin(type)
+#	define bench_end(type)
+#endif
+
+/* reports what could not be compiled; only the host benchmark *
+ * defines this                                                 */
+#ifndef diag
+#	define diag(...)
+#endif
+
+/* bytes first set aside for data generated when a scene setup is *
+ * loaded; a list needing more is compiled again with what it asked *
+ * for (see list_new), as long as the game heap has room for it     */
+#ifndef ARENA_SIZE
+#	define ARENA_SIZE  0x800
+#endif
+
+/* times a list is compiled, at most, to find the storage it needs */
+#ifndef LIST_TRIES
+#	define LIST_TRIES  3
+#endif
+
+/* bytes of display lists baked ahead of time per list, for   *
+ * segments that repeat every few frames (see segprog_try_bake); *
+ * 0 disables baking                                           */
+#ifndef BAKE_BUDGET
+#	define BAKE_BUDGET  0x1000
+#endif
+
+/* longest cycle baked, in frames */
+#ifndef BAKE_PERIOD
+#	define BAKE_PERIOD  256
+#endif
+
+/* color list, compiled at load time (see colorlist_compile) */
+struct colortimeline
+{
+	uint8_t          *keys;   /* keys live here                */
+	uint8_t          *palette;/* packed colors; 0 if none      */
+	struct flag      *flag;   /* flag (0x000A, 0x0018 only)    */
+	enum8(colorkey)   which;  /* units to compute              */
+	enum8(ease)       ease;   /* ease function                 */
+	uint8_t           stride; /* bytes per packed key; 0 if the *
+	                           * keys are struct colorkey      */
+	uint8_t           spans;  /* span[] is filled in; if not,   *
+	                           * keys are walked (see seek)    */
+	uint16_t          period; /* frames per cycle (at least 1) */
+	uint16_t          num;    /* number of keys                */
+	uint16_t          cursor; /* key evaluated last            */
+	uint32_t          base;   /* frame key `cursor` starts     */
+	uint32_t          end;    /* frame last key ends           */
+	struct colorkey   key;    /* color generated last          */
+	struct
+	{
+		uint32_t       end;    /* frame key ends                */
+		uint32_t       recip;  /* (1 << 24) / next, rounded up  */
+	}                 span[1];/* one per key (num long)        */
+};
+
+/* segment addresses resolved to ram addresses at load time */
+struct ptrtable
+{
+	struct ptrtable  *next;   /* next table of same list       */
+	uint32_t         *src;    /* segment addresses             */
+	void            **addr;   /* resolved; 0 if there was no   *
+	                           * room (resolved every frame)   */
+	int               num;    /* number of addresses           */
+};
+
+/* pointer list, compiled at load time (see sequence_compile) */
+struct sequence
+{
+	struct ptrtable  *ptr;    /* pointers (num long)           */
+	uint16_t         *start;  /* first frame of each pointer,  *
+	                           * or 0 if all last `each` frames*/
+	uint32_t          period; /* frames per cycle (at least 1) */
+	uint16_t          num;    /* number of pointers            */
+	uint16_t          cursor; /* pointer selected last         */
+	uint16_t          each;   /* frames each pointer lasts     */
+	uint32_t          stride; /* if set, `ptr` holds only the  *
+	                           * first pointer, and the others *
+	                           * follow `stride` bytes apart   */
+	uint8_t           freeze; /* flag unset: 0 = hide,         *
+	                           * 1 = hold, else keep running   */
+};
+
+/* palette animation, compiled at load time (see op_compile) */
+struct palette
+{
+	struct sequence  *sq;     /* schedule (no pointers)        */
+	uint32_t          base;   /* first palette, segmented      */
+	uint32_t          stride; /* bytes from one to the next    */
+	uint16_t          tmem;   /* TMEM address, in 64-bit words */
+	uint16_t          count;  /* colors per palette            */
+};
+
+/* atlas flipbook, compiled at load time (see op_compile) */
+struct atlas
+{
+	struct sequence  *sq;     /* frame schedule (no pointers)  */
+	uint16_t          w;      /* (frame w - 1) << 2            */
+	uint16_t          h;      /* (frame h - 1) << 2            */
+	uint16_t          step;   /* frame h << 2                  */
+	uint8_t           tile;   /* tile descriptor               */
+};
+
+/* texture scroll layer, compiled at load time (see scroll_compile) */
+struct scrolllayer
+{
+	int8_t            u;      /* u speed                       */
+	int8_t            v;      /* v speed                       */
+	uint8_t           tile;   /* tile descriptor               */
+	uint8_t           last;   /* last layer of item            */
+	uint16_t          w;      /* (texture w - 1) << 2          */
+	uint16_t          h;      /* (texture h - 1) << 2          */
+	uint16_t          umask;  /* u offset wraps at umask + 1   */
+	uint16_t          vmask;  /* v offset wraps at vmask + 1   */
+};
+
+/* one frame of the underwater camera wobble (see wobble_compile) */
+struct wobble
+{
+	f32               rot[3];   /* view rotation               */
+	f32               scale[3]; /* view scale                  */
+};
+
+/* frames per wobble cycle; the phase advances 1820 units a frame */
+#define WOBBLE_STEPS  36
+
+/* how a clock counts time */
+enum clockmode
+{
+	CLOCK_GAMEPLAY = 0        /* follows gameplay_frames       */
+	, CLOCK_FLAG              /* counts frames flag is set     */
+	, CLOCK_FREE              /* counts every frame            */
+};
+
+/* time shared by every item keeping the same time, advanced once *
+ * per frame (see clock_register)                                 */
+struct clock
+{
+	struct flagcache *flag;   /* flag counted (CLOCK_FLAG)     */
+	uint32_t          time;   /* reading for the current frame */
+	uint32_t          next;   /* reading for the next frame    */
+	uint32_t          period; /* frames per cycle (0 if none)  */
+	uint32_t          local;  /* time within cycle             */
+	enum8(clockmode)  mode;   /* how time is counted           */
+};
+
+/* flag shared by every item testing it, evaluated once per frame */
+struct flagcache
+{
+	uint32_t         *word;   /* word tested (save/global/ram) */
+	uint32_t          flag;   /* flag (other types)            */
+	uint32_t          and;    /* bit selection                 */
+	enum8(flag_type)  type;   /* flag type                     */
+	uint8_t           eq;     /* if (flag() == eq)             */
+	uint8_t           active; /* result for the current frame  */
+};
+
+/* display list being generated for one ram segment */
+struct segwork
+{
+	Gfx              *work;   /* next command written          */
+	Gfx              *start;  /* first command of display list */
+	void             *pointer;/* pointer written (0 if none)   */
+	uint32_t          frame;  /* gameplay frame generated      */
+};
+
+/* each step runs in two parts: `input` runs every frame, advancing *
+ * its state and returning what its commands depend upon; `emit`   *
+ * writes those commands, only when the segment's inputs change    */
+struct op;
+typedef uint32_t (*opinput)(z64_global_t *gl, struct segwork *w, struct op *op);
+typedef void (*opemit)(z64_global_t *gl, struct segwork *w, struct op *op);
+
+/* one step of a compiled animation program (see list_compile) */
+struct op
+{
+	opinput           input_func;
+	opemit            emit;
+	uint32_t          input;  /* returned by input_func last   */
+	void             *data;   /* data (resolved or compiled)   */
+	struct flagcache *flag;   /* flag tested (0 if none)       */
+	struct clock     *clock;  /* time read (0 if none)         */
+	uint16_t          type;   /* function (for profiling only) */
+	uint16_t          time;   /* frames elapsed (internal use) */
+	uint8_t           seg;    /* ram segment                   */
+	uint8_t           every;  /* frames input is held, minus 1 */
+	uint8_t           wait;   /* frames until next update      */
+	uint8_t           raw;    /* data was not compiled, for    *
+	                           * want of room (colors only)    */
+};
+
+/* consecutive steps generating the same ram segment */
+struct segprog
+{
+	struct op        *op;     /* first step                    */
+	Gfx              *buf[2]; /* persistent display lists      */
+	Gfx              *dl;     /* display list generated last   */
+	Gfx              *bake;   /* one display list per frame of *
+	                           * cycle (0 if not baked)        */
+	struct clock     *clock;  /* selects baked list (if baked) */
+	uint16_t          num;    /* number of steps               */
+	uint16_t          size;   /* commands written, at most     */
+	uint8_t           seg;    /* ram segment                   */
+	uint8_t           flip;   /* buf[] written to last         */
+};
+
+/* animation list of one scene setup, compiled (see list_load) */
+struct listcache
+{
+	/* compiled program, one entry per segment; empty if none */
+	struct segprog   *prog;
+	int               prog_num;
+	int               prog_size; /* graph memory commands/frame */
+	
+	/* unique flags tested by the list */
+	struct flagcache *flags;
+	int               flags_num;
+	
+	/* unique clocks read by the list */
+	struct clock     *clocks;
+	int               clocks_num;
+	
+	/* camera wobble cycle, shared by every item using it; 0 if *
+	 * none does (see wobble_compile)                           */
+	struct wobble    *wobble;
+	
+	/* pointer tables, and bases of the segments they reference */
+	struct ptrtable  *ptrtables;
+	uint32_t          segs_used;  /* bit n = segment n          */
+	void             *seg_base[16];
+	
+	/* what the list was generated from */
+	void             *scene_file;
+	z64_global_t     *gl;
+	uint16_t          scene;
+	uint16_t          setup;
+	
+	/* load-time storage, allocated along with the list from the *
+	 * zelda arena (see list_new)                                 */
+	uint8_t          *arena_next;
+	uint32_t          arena_size;
+	uint32_t          arena_want; /* bytes asked for, fitting or not */
+	uint32_t          arena_need; /* of those, bytes every step and *
+	                               * segment was reserved with      */
+	uint8_t           arena[] __attribute__((aligned(8)));
+};
+
+/* empty display list, shared by every segment that draws nothing; *
+ * occupies exactly one data cache line                            */
+static const Gfx end_dl[] __attribute__((aligned(16))) =
+{
+	gsDPNoOp()
+	, gsSPEndDisplayList()
+};
+
+/* matrices selected by conditionaldraw, in the fixed-point layout *
+ * the RSP reads (integer halves first, then fractional halves)    */
+static const Mtx draw_mtx[2] __attribute__((aligned(16))) =
+{
+	/* hidden: scaled to zero */
+	{{
+		{ 0x00000000, 0x00000000, 0x00000000, 0x00000000 }
+		, { 0x00000000, 0x00000000, 0x00000000, 0x00000001 }
+		, { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }
+		, { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }
+	}}
+	
+	/* shown: identity */
+	, {{
+		{ 0x00010000, 0x00000000, 0x00000001, 0x00000000 }
+		, { 0x00000000, 0x00010000, 0x00000000, 0x00000001 }
+		, { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }
+		, { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }
+	}}
+};
 
 /* global variables contained within */
 static struct
 {
-	/* last generated color key */
-	struct colorkey Pcolorkey;
+	/* compiled animation list, of the scene setup loaded */
+	struct listcache *cur;
+	uint32_t          frames; /* gameplay_frames, last frame    */
+	uint8_t           quiet;  /* list is compiled again (no diag)*/
+
+	
+	/* used if the heap has no room for a list: it draws nothing; *
+	 * last, as the arena it ends with is empty                   */
+	struct listcache  none;
 } g;
 
-/* propagate ram segment with pointer to data */
+/* allocate storage for the current list; returns 0 if there is no room left */
+static
+void *
+arena_alloc(uint32_t size)
+{
+	struct listcache *c = g.cur;
+	uint8_t *p = c->arena_next;
+	
+	size = (size + 7) & ~7;
+	c->arena_want += size;
+	if (p + size > c->arena + c->arena_size)
+		return 0;
+	c->arena_next += size;
+	
+	return p;
+}
+
+/* resolve segment address, noting the base of the segment used */
+static
+void *
+ptr_resolve(uint32_t addr)
+{
+	struct listcache *c = g.cur;
+	
+	/* addresses that are not segmented are never relocated */
+	if (addr < 0x80000000)
+	{
+		int seg = (addr >> 24) & 0x0F;
+		
+		c->segs_used |= 1 << seg;
+		c->seg_base[seg] = (void*)zh_seg2ram(seg << 24);
+	}
+	
+	return (void*)zh_seg2ram(addr);
+}
+
 static
-inline
 void
-segment(z64_global_t *gl, int seg, void *data)
+ptrtable_resolve(struct ptrtable *t)
+{
+	int i;
+	
+	if (!t->addr)
+		return;
+	
+	for (i = 0; i < t->num; ++i)
+		t->addr[i] = ptr_resolve(t->src[i]);
+}
+
+/* returns table of `num` segment addresses, resolved */
+static
+struct ptrtable *
+ptrtable_new(uint32_t *src, int num)
+{
+	struct ptrtable *t = arena_alloc(sizeof(*t));
+	
+	if (!t)
+		return 0;
+	
+	t->src = src;
+	t->num = num;
+	t->addr = arena_alloc(sizeof(*t->addr) * num);
+	t->next = g.cur->ptrtables;
+	g.cur->ptrtables = t;
+	ptrtable_resolve(t);
+	
+	return t;
+}
+
+/* returns address `i` of table */
+static
+inline
+void *
+ptrtable_get(struct ptrtable *t, int i)
 {
-	z64_gfx_t *gfx = gl->common.gfx_ctxt;
+	if (t->addr)
+		return t->addr[i];
+	
+	return (void*)zh_seg2ram(t->src[i]);
+}
+
+/* resolve pointer tables again if a segment they use has moved *
+ * (segment 03 does whenever a room is loaded in another slot); *
+ * returns 1 if any did                                         */
+static
+int
+list_relocate(struct listcache *c)
+{
+	struct ptrtable *t;
+	int seg;
+	
+	for (seg = 0; c->segs_used >> seg; ++seg)
+		if (((c->segs_used >> seg) & 1)
+			&& (void*)zh_seg2ram(seg << 24) != c->seg_base[seg]
+		)
+			break;
 	
-	gSPSegment(gfx->poly_opa.p++, seg, data);
-	gSPSegment(gfx->poly_xlu.p++, seg, data);
+	/* none moved */
+	if (!(c->segs_used >> seg))
+		return 0;
+	
+	for (t = c->ptrtables; t; t = t->next)
+		ptrtable_resolve(t);
+	
+	return 1;
+}
+
+/* propagate ram segment with pointer to data; written into the *
+ * setup display list, which poly_opa and poly_xlu both call     */
+static
+inline
+void
+segment(Gfx **setup, int seg, void *data)
+{
+	gSPSegment((*setup)++, seg, data);
 	// TODO is `overlay` also needed, or does
 	//      the above already work for decals?
 }
@@ -29,7 +422,7 @@ segment(z64_global_t *gl, int seg, void *data)
 /* returns 1 = flag active; 0 = flag inactive */
 static
 int
-flag(z64_global_t *gl, struct flag *f)
+flag(z64_global_t *gl, struct flagcache *f)
 {
 	int r = 0;
 	
@@ -71,61 +464,181 @@ flag(z64_global_t *gl, struct flag *f)
 			r = (*(uint32_t*)(Z64GL_IS_NIGHT));
 			break;
 		
+		/* address was resolved at load time (see flag_register) */
 		case FLAG_TYPE_SAVE:
-			r = !!(
-				(*(uint32_t*)((uint8_t*)(Z64GL_SAVE_CONTEXT) + f->flag))
-				& f->and
-			);
+		case FLAG_TYPE_GLOBAL:
+		case FLAG_TYPE_RAM:
+			r = !!(*f->word & f->and);
+			break;
+	}
+	
+	return f->eq == r;
+}
+
+/* returns index of cached flag matching `f`, adding it if necessary */
+static
+int
+flag_register(z64_global_t *gl, struct flag *f)
+{
+	struct flagcache *c;
+	int i;
+	
+	for (i = 0; i < g.cur->flags_num; ++i)
+	{
+		c = g.cur->flags + i;
+		
+		if (c->type == f->type
+			&& c->flag == f->flag
+			&& c->and == f->and
+			&& c->eq == f->eq
+		)
+			return i;
+	}
+	
+	c = g.cur->flags + g.cur->flags_num;
+	c->flag = f->flag;
+	c->and = f->and;
+	c->type = f->type;
+	c->eq = f->eq;
+	c->active = 0;
+	
+	/* word-testing types: resolve address once */
+	switch (f->type)
+	{
+		case FLAG_TYPE_SAVE:
+			c->word = (void*)((uint8_t*)(Z64GL_SAVE_CONTEXT) + f->flag);
 			break;
 		
 		case FLAG_TYPE_GLOBAL:
-			r = !!(
-				(*(uint32_t*)((uint8_t*)(gl) + f->flag)) & f->and
-			);
+			c->word = (void*)((uint8_t*)(gl) + f->flag);
 			break;
 		
 		case FLAG_TYPE_RAM:
-			r = !!((*(uint32_t*)(f->flag)) & f->and);
+			c->word = (void*)f->flag;
 			break;
 	}
 	
-	return f->eq == r;
+	return g.cur->flags_num++;
+}
+
+/* returns clock counting time as described, adding it if necessary; *
+ * items keeping identical time share one, so each cycle position   *
+ * is worked out once per frame however many items read it          */
+static
+struct clock *
+clock_register(enum8(clockmode) mode, struct flagcache *f, uint32_t start, uint32_t period)
+{
+	struct clock *ck;
+	
+	/* gameplay clocks are never started elsewhere */
+	if (mode == CLOCK_GAMEPLAY)
+		f = 0, start = 0;
+	
+	for (ck = g.cur->clocks; ck < g.cur->clocks + g.cur->clocks_num; ++ck)
+		if (ck->mode == mode
+			&& ck->flag == f
+			&& ck->next == start
+			&& ck->period == period
+		)
+			return ck;
+	
+	ck->mode = mode;
+	ck->flag = f;
+	ck->next = start;
+	ck->period = period;
+	
+	/* seeded so that time 0 is reached by advancing once */
+	ck->time = -1;
+	ck->local = period ? period - 1 : -1;
+	
+	g.cur->clocks_num += 1;
+	return ck;
+}
+
+/* advance clock to gameplay frame `frame` */
+static
+void
+clock_tick(struct clock *ck, uint32_t frame)
+{
+	uint32_t time = frame;
+	
+	/* counted clocks read what was counted before this frame */
+	if (ck->mode != CLOCK_GAMEPLAY)
+	{
+		time = ck->next;
+		ck->next += (ck->mode == CLOCK_FREE || ck->flag->active);
+	}
+	
+	/* advance within the cycle, avoiding a divide where possible */
+	if (!ck->period)
+		ck->local = time;
+	else if (time == ck->time + 1)
+	{
+		if (++ck->local >= ck->period)
+			ck->local = 0;
+	}
+	else if (time != ck->time)
+		ck->local = time % ck->period;
+	
+	ck->time = time;
 }
 
+/* returns flag embedded in an animation's data; 0 if it has none */
+static
+struct flag *
+anim_flag(int type, void *data)
+{
+	switch (type)
+	{
+		case 0x0007: return &((struct pointer_flag*)data)->flag;
+		case 0x0008: return &((struct scroll_flag*)data)->flag;
+		case 0x000A: return &((struct colorlist_flag*)data)->flag;
+		case 0x000C: return &((struct pointer_loop_flag*)data)->flag;
+		case 0x000E: return &((struct pointer_timeloop_flag*)data)->flag;
+		case 0x000F: return &((struct cameraeffect*)data)->flag;
+		case 0x0010: return &((struct conditionaldraw*)data)->flag;
+		case 0x0012: return &((struct pointer_stride_flag*)data)->flag;
+		case 0x0016: return &((struct scroll_tiles_flag*)data)->flag;
+		case 0x0018: return &((struct colorlist_packed_flag*)data)->flag;
+	}
+	
+	return 0;
+}
 
+/* blend factors are 8.8 fixed-point; EASE_ONE is 1.0 */
+#define EASE_ONE  0x100
 
 static
 inline
 int
-ease_int(int from, int to, float factor)
+ease_int(int from, int to, uint32_t factor)
 {
-	return from + (to - from) * factor;
+	return from + (((to - from) * (int)factor) >> 8);
 }
 
 static
 inline
 int
-ease_8(int from, int to, float factor)
+ease_8(int from, int to, uint32_t factor)
 {
 	return ease_int(from, to, factor) & 0xFF;
 }
 
-
+/* blends all four 8-bit channels at once: two channels per *
+ * 16-bit lane, no floating point involved                  */
 static
 inline
 uint32_t
-ease_rgba(uint32_t from, uint32_t to, float factor)
+ease_rgba(uint32_t from, uint32_t to, uint32_t factor)
 {
-	uint8_t rgba[4];
-	uint8_t *from8 = (uint8_t*)&from;
-	uint8_t *to8 = (uint8_t*)&to;
+	uint32_t inv = EASE_ONE - factor;
+	uint32_t lo;
+	uint32_t hi;
 	
-	rgba[0] = ease_int(from8[0], to8[0], factor);
-	rgba[1] = ease_int(from8[1], to8[1], factor);
-	rgba[2] = ease_int(from8[2], to8[2], factor);
-	rgba[3] = ease_int(from8[3], to8[3], factor);
+	lo = (from & 0x00FF00FF) * inv + (to & 0x00FF00FF) * factor;
+	hi = ((from >> 8) & 0x00FF00FF) * inv + ((to >> 8) & 0x00FF00FF) * factor;
 	
-	return *(uint32_t*)rgba;
+	return ((lo >> 8) & 0x00FF00FF) | (hi & 0xFF00FF00);
 }
 
 static
@@ -166,7 +679,7 @@ static
 void
 colorkey_blend(
 	enum8(colorkey_types) which
-	, float factor
+	, uint32_t factor
 	, struct colorkey *from
 	, struct colorkey *to
 	, struct colorkey *result
@@ -197,279 +710,596 @@ colorkey_blend(
 	}
 }
 
+/* returns 8.8 fixed-point blend factor, given `frame` as 0.8 *
+ * fixed-point progress through the key (0x00 - 0xFF)         */
 static
-float
-interp(uint32_t frame, uint32_t next, enum8(ease) ease)
+uint32_t
+interp(uint32_t frame, enum8(ease) ease)
 {
-	float factor;
-	
-	if (!next)
-		return 0;
-	
-	factor = frame;
+	const uint16_t *t;
 	
-	/* normalize factor */
-	factor /= next;
-	
-	// TODO transform factor with easing transformations
-#define M_PI 3.14579
-	if (ease != EASE_LINEAR)
+	switch (ease)
 	{
-		switch (ease)
-		{
-			/* sinusoidal (in) */
-			case EASE_SIN_IN:
-				break;
-			
-			/* sinusoidal (out) */
-			case EASE_SIN_OUT:
-				break;
-			
-			/* unsupported: use linear */
-			default:
-				break;
-		}
+		/* curves: sample table, then blend between neighbors */
+		case EASE_SIN_IN:
+		case EASE_SIN_OUT:
+		case EASE_QUAD_IN:
+		case EASE_QUAD_OUT:
+		case EASE_CUBIC_IN:
+		case EASE_CUBIC_OUT:
+			t = ease_table[ease - EASE_SIN_IN] + (frame >> 2);
+			return t[0] + (((t[1] - t[0]) * (frame & 3)) >> 2);
+		
+		/* hold previous key until this one is reached */
+		case EASE_STEP:
+			return 0;
+		
+		/* linear, or unsupported: use linear */
+		default:
+			return frame;
 	}
-	
-	return factor;
 }
 
+/* returns frames from key `i` of a timeline until the next one */
 static
 inline
-void
-color_loop(z64_global_t *gl, Gfx **work, struct colorlist *list)
+uint32_t
+colortimeline_next(struct colortimeline *tl, int i)
 {
-	// noka: rewrote entire function because it didnt function correctly
-
-	struct colorkey *from;
-	struct colorkey *to;
-	struct colorkey *lastkey = NULL;
-	struct colorkey *prevkey;
-	struct colorkey *key;
-
-	u32 totalframes = list->dur;
-	if (!list->dur)
-		totalframes = 1;
-	u32 tempframe = 0;
-	u32 globalframe = gl->gameplay_frames;
-
-	//get last key in the list
-	for (key = list->key; key->next; ++key)
-	{
-		lastkey = key;
-	}
-
-	u32 currentframe = globalframe % totalframes;
-	u32 relativeframe = currentframe;
-	u32 i = 0;
-
-	//these 2 lines avoid a crash
-	from = list->key;
-	to = list->key;
+	if (tl->stride)
+		return tl->keys[i * tl->stride];
+	
+	return ((struct colorkey*)tl->keys)[i].next;
+}
 
-	for (key = list->key; key->next; ++key)
+/* compile keys into a timeline of cumulative key frames; with *
+ * `view`, nothing is allocated: the timeline is written there, *
+ * without spans, and keys are walked in place instead; so are  *
+ * packed keys (`stride`), which spans would outweigh            */
+static
+struct colortimeline *
+colortimeline_new(
+	struct colortimeline *view
+	, void *keys
+	, void *palette
+	, int stride
+	, int num
+	, struct colorlist *list
+	, struct flag *flag
+)
+{
+	struct colortimeline *tl = view;
+	int spans = !view && !stride;
+	
+	if (!tl)
+		tl = arena_alloc(sizeof(*tl) + sizeof(tl->span[0]) * (spans && num ? num - 1 : 0));
+	if (!tl)
+		return 0;
+	
+	tl->keys = keys;
+	tl->palette = palette;
+	tl->stride = stride;
+	tl->flag = flag;
+	tl->which = list->which;
+	tl->ease = list->ease;
+	tl->spans = spans;
+	tl->num = num;
+	tl->cursor = 0;
+	tl->base = 0;
+	tl->end = 0;
+	tl->period = list->dur ? list->dur : 1;
+	
+	/* channels no key names stay 0, whatever list came before */
+	tl->key.prim = tl->key.env = 0;
+	tl->key.lfrac = tl->key.mlevel = 0;
+	
+	/* spans are divided out once, here; keys walked in place are *
+	 * timed with recip_table instead, so per-frame blending never *
+	 * divides either way                                          */
+	for (num = 0; num < tl->num; ++num)
 	{
-		tempframe += key->next;
-
-        if (currentframe < tempframe)
-        {
-        	//set keyframes and blend the colors
-
-            to = key;
-
-            if (i == 0 && !key->next)
-            {
-                from = key;
-            }
-            else
-            {
-                if (i == 0)
-                    from = lastkey;
-                else
-					from = prevkey;
-                
-            }
-
-           
-
-            float lerpamount = 0.0f;
-
-            if (relativeframe != 0) lerpamount = (1.0f/ to->next) * (float)(relativeframe);
-
-			colorkey_blend(list->which, lerpamount, from, to, &g.Pcolorkey);
-			
-			colorkey_put(list->which, work, &g.Pcolorkey);
-
-
-            break;
-        }
-        relativeframe -= key->next;
-        prevkey = key;
-        i++;
-
-
+		uint32_t next = colortimeline_next(tl, num);
+		
+		tl->end += next;
+		if (!tl->spans)
+			continue;
+		tl->span[num].end = tl->end;
+		tl->span[num].recip = ((1 << 24) + next - 1) / next;
 	}
-
 	
-
+	return tl;
 }
 
+/* compile color list into a timeline */
 static
-inline
-void
-color_loop_flag(z64_global_t *gl, Gfx **work, struct colorlist_flag *c)
+struct colortimeline *
+colorlist_compile(struct colorlist *list, struct flag *flag, struct colortimeline *view)
 {
-	//xfading commented out to save space
-
-	struct flag *f = &c->flag;
-	struct colorlist *list = &c->list;
-	
 	struct colorkey *key;
-	//struct colorkey  Nkey;
-	int active = flag(gl, f);
-	//int xfading = (f->frames || active) && f->frames <= f->xfade && f->xfade;
-	
-	enum8(colorkey_types) which = list->which;
+	int num = 0;
 	
-	//if (flag(gl, &scroll->flag))
-	//	scroll->flag.frames++;
+	/* the last key (next == 0) only terminates the list */
+	for (key = list->key; key->next; ++key)
+		++num;
 	
-	/* if not cross fading, write to Pcolorkey */
-	/*
-	if (!xfading)
-		key = &g.Pcolorkey;
-	else
-		key = &Nkey;*/
+	return colortimeline_new(view, list->key, 0, 0, num, list, flag);
+}
 
-	key = &g.Pcolorkey;
+/* compile packed color list into a timeline; its keys are *
+ * read in place, unpacked one at a time as they are blended */
+static
+struct colortimeline *
+colorlist_packed_compile(struct colorlist_packed *list, struct flag *flag, struct colortimeline *view)
+{
+	struct colorlist head;
+	uint8_t *keys = list->data + list->colors * 4;
+	int color = list->colors ? 1 : 4;
+	int stride = 1;
+	int num;
+	
+	if (list->which & COLORKEY_PRIM)     stride += color;
+	if (list->which & COLORKEY_ENV)      stride += color;
+	if (list->which & COLORKEY_LODFRAC)  stride += 1;
+	if (list->which & COLORKEY_MINLEVEL) stride += 1;
+	
+	head.which = list->which;
+	head.ease = list->ease;
+	head.dur = list->dur;
+	
+	/* a key lasting 0 frames would divide by zero; end there */
+	for (num = 0; num < list->num; ++num)
+		if (!keys[num * stride])
+			break;
 	
-	/* not across-fading, and flag is not active */
-	if (!active && !f->frames && !f->freeze)
-		return;
+	return colortimeline_new(
+		view
+		, keys
+		, list->colors ? list->data : 0
+		, stride
+		, num
+		, &head
+		, flag
+	);
+}
+
+/* compile data of color step `type` (see colortimeline_new) */
+static
+struct colortimeline *
+color_compile(int type, void *data, struct colortimeline *view)
+{
+	struct flag *f = anim_flag(type, data);
 	
-	/* if cross fading or flag is active, compute colors */
-	if (active)//|| xfading
-	{
-		color_loop(gl, work, list);
-	}
-	else 
-		colorkey_put(which, work, key);
+	if (!data)
+		return 0;
 	
-	/* if cross fading, interpolate between old and new colors */
-
-	/*
-	if (xfading)
+	switch (type)
 	{
-		float factor;
+		case 0x0009:
+			return colorlist_compile(data, 0, view);
 		
-		if (active)
-			f->frames += f->frames < f->xfade;
-		else
-			f->frames -= f->frames > 0;
+		case 0x000A:
+			return colorlist_compile(&((struct colorlist_flag*)data)->list, f, view);
 		
-		factor = interp(f->frames, f->xfade, list->ease);
+		case 0x0017:
+			return colorlist_packed_compile(data, 0, view);
 		
-		// blend color keys (result goes into Pcolorkey) 
-		colorkey_blend(which, factor, &g.Pcolorkey, key, &g.Pcolorkey);
-		key = &g.Pcolorkey;
-	}*/
-
-	//colorkey_put(which, work, key);
+		case 0x0018:
+			data = &((struct colorlist_packed_flag*)data)->list;
+			return colorlist_packed_compile(data, f, view);
+	}
 	
+	return 0;
 }
 
+/* returns timeline of color step; steps whose timelines did not *
+ * fit are read from the scene file as they were before compiling *
+ * existed, through a timeline written to `view` every frame      */
 static
-inline
-int
-abs_int(int x)
+struct colortimeline *
+color_timeline(struct op *op, struct colortimeline *view)
 {
-	return (x < 0) ? -x : x;
+	if (!op->raw)
+		return op->data;
+	
+	return color_compile(op->type, op->data, view);
 }
 
-/* TODO zh_seg2ram should do the same thing; test it later */
+/* returns key `i` of a timeline; packed keys are unpacked into `buf` */
 static
-inline
-void *
-mkabs(z64_global_t *gl, void *ptr)
+struct colorkey *
+colortimeline_key(struct colortimeline *tl, int i, struct colorkey *buf)
 {
-	unsigned char *scene = gl->scene_file;
-	uint32_t ptr32 = (uint32_t)ptr;
+	uint8_t *src;
+	uint8_t *dst;
+	int k;
 	
-	if (!ptr)
-		return 0;
+	if (!tl->stride)
+		return (struct colorkey*)tl->keys + i;
 	
-	scene += ptr32 & 0xFFFFFF;
+	src = tl->keys + i * tl->stride + 1;
+	buf->prim = buf->env = 0;
+	buf->lfrac = buf->mlevel = 0;
 	
-	return scene;
-}
-
-/* change pointer based on flag */
-static
-void
-pointer_flag(z64_global_t *gl, Gfx **work, struct pointer_flag *ptr)
-{
-	// TODO don't forget to uncomment this
-	*work = (void*)zh_seg2ram(ptr->ptr[flag(gl, &ptr->flag)]);
-	// testing:
-	//*work = (void*)zh_seg2ram(ptr->ptr[0]);
+	for (k = 0; k < 2; ++k)
+	{
+		uint8_t *rgba = src;
+		
+		if (!(tl->which & (k ? COLORKEY_ENV : COLORKEY_PRIM)))
+			continue;
+		
+		/* palette entries and colors are both rgba bytes */
+		if (tl->palette)
+			rgba = tl->palette + *src++ * 4;
+		else
+			src += 4;
+		
+		dst = (uint8_t*)(k ? &buf->env : &buf->prim);
+		dst[0] = rgba[0];
+		dst[1] = rgba[1];
+		dst[2] = rgba[2];
+		dst[3] = rgba[3];
+	}
+	
+	if (tl->which & COLORKEY_LODFRAC)
+		buf->lfrac = *src++;
+	
+	if (tl->which & COLORKEY_MINLEVEL)
+		buf->mlevel = *src++;
+	
+	return buf;
+}
+
+/* returns index of key active `local` frames into cycle; -1 if none */
+static
+int
+colortimeline_seek(struct colortimeline *tl, uint32_t local)
+{
+	int i = tl->cursor;
+	
+	/* list has no keys, or cycle outlasts them */
+	if (!tl->num || local >= tl->end)
+		return -1;
+	
+	/* no spans: walk keys, from where the last search ended */
+	if (!tl->spans)
+	{
+		if (local < tl->base)
+			i = 0, tl->base = 0;
+		while (local >= tl->base + colortimeline_next(tl, i))
+			tl->base += colortimeline_next(tl, i++);
+		tl->cursor = i;
+		return i;
+	}
+	
+	/* usually the key from last time, or the one after it */
+	if (local < tl->span[i].end && (!i || local >= tl->span[i - 1].end))
+		return i;
+	if (i + 1 < tl->num && local >= tl->span[i].end && local < tl->span[i + 1].end)
+		i += 1;
+	
+	/* anything else: binary search for first key ending after local */
+	else
+	{
+		int lo = 0;
+		int hi = tl->num - 1;
+		
+		while (lo < hi)
+		{
+			int mid = (lo + hi) >> 1;
+			
+			if (local < tl->span[mid].end)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		i = lo;
+	}
+	
+	tl->cursor = i;
+	return i;
+}
+
+/* color list input that holds the color generated last */
+#define COLOR_HOLD  1
+
+/* returns what color list draws `local` frames into its cycle: *
+ * 0 for nothing, else (key index + 1) << 8 | 0.8 progress       */
+static
+uint32_t
+color_timeline_input(uint32_t local, struct colortimeline *tl)
+{
+	uint32_t relativeframe;
+	uint32_t progress;
+	uint32_t recip;
+	int i;
+	
+	i = colortimeline_seek(tl, local);
+	if (i < 0)
+		return 0;
+	
+	if (tl->spans)
+	{
+		relativeframe = local - (i ? tl->span[i - 1].end : 0);
+		recip = tl->span[i].recip;
+	}
+	else
+	{
+		uint32_t next = colortimeline_next(tl, i);
+		
+		relativeframe = local - tl->base;
+		
+		/* packed keys last 255 frames at most; raw keys read in *
+		 * place may last longer, and are timed in coarser steps */
+		while (next > 0xFF)
+			next >>= 1, relativeframe >>= 1;
+		recip = recip_table[next];
+	}
+	
+	/* 0.8 fixed-point progress through key */
+	progress = (relativeframe * recip) >> 16;
+	if (progress > 0xFF)
+		progress = 0xFF;
+	
+	return ((i + 1) << 8) | progress;
 }
 
-/* change pointer as time progresses (each pointer has its own time) */
+/* write colors for input returned by color_timeline_input */
 static
 void
-pointer_timeloop(z64_global_t *gl, Gfx **work, struct pointer_timeloop *ptr)
+color_timeline_put(Gfx **work, struct colortimeline *tl, uint32_t input)
 {
-	int item;
-	int num = ptr->num;
-	uint32_t *list = (void*)(ptr->each + num + !(num & 1));
+	struct colorkey buf[2];
+	struct colorkey *from;
+	struct colorkey *to;
+	int i = (input >> 8) - 1;
+	int prev;
 	
-	/* walk list */
-	for (item = ptr->prev; item < num; ++item)
-		if (ptr->time >= ptr->each[item])
-			break;
+	if (!input || !tl)
+		return;
+	
+	if (input != COLOR_HOLD)
+	{
+		/* blend from previous key (wrapping around) into this one */
+		prev = i ? i - 1 : tl->num - 1;
+		to = colortimeline_key(tl, i, &buf[0]);
+		from = (prev == i) ? to : colortimeline_key(tl, prev, &buf[1]);
+		
+		colorkey_blend(
+			tl->which
+			, interp(input & 0xFF, tl->ease)
+			, from
+			, to
+			, &tl->key
+		);
+	}
+	
+	colorkey_put(tl->which, work, &tl->key);
+}
+
+/* loop through color list */
+static
+uint32_t
+color_loop_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct colortimeline view;
+	struct colortimeline *tl = color_timeline(op, &view);
 	
-	/* reached end of animation; roll back to beginning */
-	if (item >= num - 1)
-		item = ptr->prev = ptr->time = 0;
+	if (!tl)
+		return 0;
+	
+	return color_timeline_input(op->clock->local, tl);
+}
+
+static
+void
+color_loop(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct colortimeline view;
+	
+	color_timeline_put(&w->work, color_timeline(op, &view), op->input);
+}
+
+/* loop through color list, with flag */
+static
+uint32_t
+color_loop_flag_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	//xfading commented out to save space
+
+	struct colortimeline view;
+	struct colortimeline *tl = color_timeline(op, &view);
+	int active = op->flag->active;
+	struct flag *f;
+	
+	//int xfading = (f->frames || active) && f->frames <= f->xfade && f->xfade;
+	
+	if (!tl)
+		return 0;
+	
+	f = tl->flag;
+	
+	//if (flag(gl, &scroll->flag))
+	//	scroll->flag.frames++;
+	
+	/* not across-fading, and flag is not active */
+	if (!active && !f->frames && !f->freeze)
+		return 0;
+	
+	/* if cross fading or flag is active, compute colors */
+	if (active)//|| xfading
+		return color_timeline_input(op->clock->local, tl);
 	
-	*work = (void*)zh_seg2ram(list[item]);
+	/* otherwise, hold the last color; a timeline read in place *
+	 * keeps none, so it holds the input generating it instead   */
+	return (tl == &view) ? op->input : COLOR_HOLD;
 	
-	/* increment time elapsed */
-	ptr->time += 1;
-	if (ptr->time == ptr->each[item+1])
-		ptr->prev += 1;
+	/* if cross fading, interpolate between old and new colors */
+
+	/*
+	if (xfading)
+	{
+		float factor;
+		
+		if (active)
+			f->frames += f->frames < f->xfade;
+		else
+			f->frames -= f->frames > 0;
+		
+		factor = interp(f->frames, f->xfade, list->ease);
+		
+		// blend color keys (result goes into Pcolorkey) 
+		colorkey_blend(which, factor, &g.Pcolorkey, key, &g.Pcolorkey);
+		key = &g.Pcolorkey;
+	}*/
 }
 
-/* change pointer as time progresses (each pointer has its own time) */
-/* skipped if flag is undesirable */
 static
+inline
 int
-pointer_timeloop_flag(z64_global_t *gl, Gfx **work, struct pointer_timeloop_flag *_ptr)
+abs_int(int x)
+{
+	return (x < 0) ? -x : x;
+}
+
+/* TODO zh_seg2ram should do the same thing; test it later */
+static
+inline
+void *
+mkabs(z64_global_t *gl, uint32_t ptr32)
 {
-	struct pointer_timeloop *ptr = &_ptr->list;
-	if (!flag(gl, &_ptr->flag))
+	unsigned char *scene = gl->scene_file;
+	
+	if (!ptr32)
 		return 0;
 	
-	pointer_timeloop(gl, work, ptr);
-	return 1;
+	scene += ptr32 & 0xFFFFFF;
+	
+	return scene;
+}
+
+/* change pointer based on flag */
+static
+uint32_t
+pointer_flag(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct ptrtable *ptr = op->data;
+	
+	if (w->pointer || !ptr)
+		return 0;
+	
+	// TODO don't forget to uncomment this
+	w->pointer = ptrtable_get(ptr, op->flag->active);
+	// testing:
+	//w->pointer = ptrtable_get(ptr, 0);
+	
+	return 0;
+}
+
+/* compile pointer list; `start` is 0 if each pointer lasts `each` *
+ * frames; `stride` is 0 unless only the first pointer is listed;   *
+ * `ptr` is 0 for schedules selecting something else               */
+static
+struct sequence *
+sequence_compile(uint32_t *ptr, uint16_t *start, int num, uint32_t period, int each, uint32_t stride, int freeze)
+{
+	struct sequence *sq = arena_alloc(sizeof(*sq));
+	
+	if (!sq)
+		return 0;
+	
+	sq->start = start;
+	sq->each = each ? each : 1;
+	sq->period = period ? period : 1;
+	sq->num = start ? num : (sq->period + sq->each - 1) / sq->each;
+	if (!sq->num)
+		sq->num = 1;
+	sq->stride = stride;
+	sq->ptr = ptr ? ptrtable_new(ptr, stride ? 1 : sq->num) : 0;
+	if (ptr && !sq->ptr)
+		return 0;
+	sq->freeze = freeze;
+	sq->cursor = sq->num - 1;
+	
+	return sq;
+}
+
+/* returns first frame of item `i` in sequence */
+static
+inline
+uint32_t
+sequence_start(struct sequence *sq, int i)
+{
+	if (i >= sq->num)
+		return sq->period;
+	
+	return sq->start ? sq->start[i] : i * sq->each;
+}
+
+/* returns pointer `i` of sequence */
+static
+inline
+void *
+sequence_pointer(struct sequence *sq, int i)
+{
+	if (sq->stride)
+		return (uint8_t*)ptrtable_get(sq->ptr, 0) + i * sq->stride;
+	
+	return ptrtable_get(sq->ptr, i);
+}
+
+/* returns index of pointer shown `local` frames into cycle */
+static
+int
+sequence_seek(struct sequence *sq, uint32_t local)
+{
+	int i = sq->cursor;
+	
+	/* usually the pointer from last time, the one after it, *
+	 * or the first one once the cycle starts over           */
+	if (local >= sequence_start(sq, i) && local < sequence_start(sq, i + 1))
+		return i;
+	if (local >= sequence_start(sq, i + 1) && local < sequence_start(sq, i + 2))
+		i += 1;
+	else if (local < sequence_start(sq, 1))
+		i = 0;
+	
+	/* anything else: look it up */
+	else if (!sq->start)
+		i = local / sq->each;
+	else
+	{
+		int lo = 0;
+		int hi = sq->num - 1;
+		
+		while (lo < hi)
+		{
+			int mid = (lo + hi + 1) >> 1;
+			
+			if (local >= sq->start[mid])
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		i = lo;
+	}
+	
+	sq->cursor = i;
+	return i;
 }
 
 /* change pointer as time progresses */
 static
-void
-pointer_loop(z64_global_t *gl, Gfx **work, struct pointer_loop *ptr)
+uint32_t
+pointer_sequence(z64_global_t *gl, struct segwork *w, struct op *op)
 {
-	int item;
+	struct sequence *sq = op->data;
 	
-	/* overflow test */
-	if (ptr->time >= ptr->dur)
-		ptr->time = 0;
+	if (w->pointer || !sq)
+		return 0;
 	
-	item = ptr->time / ptr->each;
-	*work = (void*)zh_seg2ram(ptr->ptr[item]);
+	w->pointer = sequence_pointer(sq, sequence_seek(sq, op->clock->local));
 	
-	/* increment time elapsed */
-	ptr->time += 1;
+	return 0;
 }
 
 /* displays matrix hex values onto the screen */
@@ -490,253 +1320,1265 @@ static void print_matrix(z64_global_t *gl, void *_mtx)
 	zh_text_done();
 }
 
-/* change pointer as time progresses */
-/* skipped if flag is undesirable */
+/* change pointer as time progresses, counting only frames the *
+ * flag is set (see clock_register); skipped if flag is          *
+ * undesirable, unless frozen                                    */
 static
-int
-pointer_loop_flag(z64_global_t *gl, Gfx **work, struct pointer_loop_flag *_ptr)
+uint32_t
+pointer_sequence_flag(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct sequence *sq = op->data;
+	int active = op->flag->active;
+	
+	if (w->pointer || !sq)
+		return 0;
+	
+	if (!active && !sq->freeze)
+		return 0;
+	
+	w->pointer = sequence_pointer(sq, sequence_seek(sq, op->clock->local));
+	
+	return 0;
+}
+
+/* pointer step that did not write a pointer: display list starts here */
+static
+void
+pointer_skipped(z64_global_t *gl, struct segwork *w, struct op *op)
 {
-	struct pointer_loop *ptr = &_ptr->list;
-	u8 flagstate = flag(gl, &_ptr->flag);
-	struct flag *f = &_ptr->flag;
+	w->start = w->work;
+}
 
-	if (!flagstate && f->freeze == 0)
+/* palette shown on this frame; 0 if none */
+static
+uint32_t
+palette_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct palette *pl = op->data;
+	
+	if (!pl)
 		return 0;
 	
-	pointer_loop(gl, work, ptr);
+	return sequence_seek(pl->sq, op->clock->local) + 1;
+}
 
+/* load palette into TMEM, so only the palette changes, never texels; *
+ * its address stays segmented, so display lists holding it are never *
+ * out of date when the segment moves                                */
+static
+void
+palette(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct palette *pl = op->data;
+	
+	if (!op->input)
+		return;
+	
+	gDPLoadTLUT(
+		w->work++
+		, pl->count
+		, pl->tmem
+		, pl->base + (op->input - 1) * pl->stride
+	);
+}
 
-	// if freeze mode is set, time doesnt advance when flag is not set
-	if (!flagstate && f->freeze == 1)
-		ptr->time -= 1;
+/* atlas frame shown on this frame */
+static
+uint32_t
+atlas_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct atlas *at = op->data;
+	
+	if (!at)
+		return 0;
 	
+	return sequence_seek(at->sq, op->clock->local);
+}
 
-	return 1;
+/* select atlas frame by moving the tile over it, the same way *
+ * scrolling does; the texture itself is loaded only once       */
+static
+void
+atlas(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct atlas *at = op->data;
+	uint32_t t;
+	
+	if (!at)
+		return;
+	
+	t = op->input * at->step;
+	gDPTileSync(w->work++);
+	gDPSetTileSize(w->work++, at->tile, 0, t, at->w, t + at->h);
+}
+
+/* returns mask wrapping 10.2 texel offsets at texture size, rounded *
+ * up to a power of two the way the RDP wraps it                      */
+static
+uint16_t
+scroll_mask(int texels)
+{
+	int n = 1;
+	
+	/* size 0 is taken to mean 256 */
+	if (!texels)
+		texels = 256;
+	
+	while (n < texels)
+		n <<= 1;
+	
+	return (n << 2) - 1;
+}
+
+/* compile one scroll layer of a texture `w` by `h` texels; *
+ * size 0 is taken to mean 256, as it is by scroll_mask      */
+static
+void
+scroll_layer(struct scrolllayer *sl, int tile, int u, int v, int w, int h, int last)
+{
+	if (!w)
+		w = 256;
+	if (!h)
+		h = 256;
+	
+	sl->u = u;
+	sl->v = v;
+	sl->tile = tile;
+	sl->last = last;
+	sl->w = (w - 1) << 2;
+	sl->h = (h - 1) << 2;
+	sl->umask = scroll_mask(w);
+	sl->vmask = scroll_mask(h);
+}
+
+/* compile `num` scroll layers */
+static
+struct scrolllayer *
+scroll_compile(struct scroll *sc, int num)
+{
+	struct scrolllayer *sl = arena_alloc(sizeof(*sl) * num);
+	int i;
+	
+	if (!sl)
+		return 0;
+	
+	for (i = 0; i < num; ++i, ++sc)
+		scroll_layer(sl + i, i, sc->u, sc->v, sc->w, sc->h, i == num - 1);
+	
+	return sl;
+}
+
+/* compile `num` scroll layers, each naming its own tile */
+static
+struct scrolllayer *
+scroll_tiles_compile(struct scroll_tile *st, int num)
+{
+	struct scrolllayer *sl;
+	int i;
+	
+	if (!num || !(sl = arena_alloc(sizeof(*sl) * num)))
+		return 0;
+	
+	for (i = 0; i < num; ++i, ++st)
+		scroll_layer(sl + i, st->tile, st->u, st->v, st->w, st->h, i == num - 1);
+	
+	return sl;
+}
+
+/* scroll layers change every frame, unless they are stationary */
+static
+uint32_t
+scroll_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct scrolllayer *sl = op->data;
+	
+	if (!sl)
+		return 0;
+	
+	for ( ; ; ++sl)
+	{
+		if (sl->u || sl->v)
+			return w->frame;
+		if (sl->last)
+			return 0;
+	}
+}
+
+/* scroll one or more tile layers to where they are on `frame`; *
+ * offsets are wrapped, so they never lose precision however    *
+ * long the game runs                                           */
+static
+void
+scroll_layers(struct segwork *w, struct scrolllayer *sl, uint32_t frame)
+{
+	if (!sl)
+		return;
+	
+	for ( ; ; ++sl)
+	{
+		uint32_t x = (sl->u * frame) & sl->umask;
+		uint32_t y = -(sl->v * frame) & sl->vmask;
+		
+		gDPTileSync(w->work++);
+		gDPSetTileSize(w->work++, sl->tile, x, y, x + sl->w, y + sl->h);
+		
+		if (sl->last)
+			break;
+	}
+}
+
+static
+void
+scroll(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	scroll_layers(w, op->data, op->input);
+}
+
+/* scroll layers, counting only frames flag is set (see scroll_flag_input) */
+static
+void
+scroll_tiles_flag(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	scroll_layers(w, op->data, op->input);
+}
+
+/* scroll tiles based on flag; frames flag has been on are counted *
+ * by the step's clock                                             */
+static
+uint32_t
+scroll_flag_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	return op->clock->local;
+}
+
+static
+void
+scroll_flag(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct scroll_flag *scroll = op->data;
+	struct scroll *sc = scroll->sc;
+	struct scroll *sc1 = sc + 1;
+	uint16_t frame = op->input;
+	
+	gDPSetTileSize(
+		w->work++
+		, 0,  sc->u * frame,  sc->v * frame,  sc->w,  sc->h
+	);
+	
+	gDPSetTileSize(
+		w->work++
+		, 1, sc1->u * frame, sc1->v * frame, sc1->w, sc1->h
+	);
+}
+
+
+/* the host benchmark (src/host) provides its own versions of these */
+#ifndef Z64SCENE_HOST
+extern void external_func_800AA76C(void* view, f32 arg1, f32 arg2, f32 arg3);
+		asm("external_func_800AA76C = 0x800AA76C");
+
+extern void external_func_800AA78C(void* view, f32 arg1, f32 arg2, f32 arg3);
+		asm("external_func_800AA78C = 0x800AA78C");
+
+extern void external_func_800AA7AC(void* view, f32 arg1);
+		asm("external_func_800AA7AC = 0x800AA7AC");
+
+extern s32 FrameAdvance_IsEnabled(z64_global_t *gl);
+		asm("FrameAdvance_IsEnabled = 0x800C0D28");
+
+extern void external_func_8009BEEC(z64_global_t *gl);
+		asm("external_func_8009BEEC = 0x8009BEEC");
+#endif /* Z64SCENE_HOST */
+
+
+/* tabulate one cycle of the underwater camera wobble, so each *
+ * frame reads its view rotation and scale instead of working   *
+ * them out with six sines and cosines; one table per list, and *
+ * only for lists using it                                      */
+static
+void
+wobble_compile(void)
+{
+	const f32 amp = 0.020000001f;
+	const f32 rot = (360.00018f / 65535.0f) * (3.14159265f / 180.0f) * amp;
+	struct listcache *c = g.cur;
+	int i;
+	
+	if (c->wobble || !(c->wobble = arena_alloc(sizeof(*c->wobble) * WOBBLE_STEPS)))
+		return;
+	
+	for (i = 0; i < WOBBLE_STEPS; ++i)
+	{
+		struct wobble *wb = c->wobble + i;
+		s16 a = 538 + 1820 * (i + 1);
+		s16 b = 4272 + 1820 * (i + 1);
+		
+		wb->rot[0] = rot * Math_Coss(a);
+		wb->rot[1] = rot * Math_Sins(a);
+		wb->rot[2] = rot * Math_Sins(b);
+		wb->scale[0] = 1.f + (0.79999995f * amp * Math_Sins(b));
+		wb->scale[1] = 1.f + (0.39999998f * amp * Math_Coss(b));
+		wb->scale[2] = 1.f + (1 * amp * Math_Coss(a));
+	}
+}
+
+/* camera effect while flag is set: 0 = shake, else wobble as in *
+ * Jabu-Jabu's belly; each item keeps its own phase in op->time  */
+static
+uint32_t
+cameraeffect(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	struct cameraeffect *cam = op->data;
+	struct wobble *wb;
+	
+	if (!op->flag->active)
+		return 0;
+	
+	if (cam->cameratype == 0)
+	{
+		external_func_8009BEEC(gl);
+		return 0;
+	}
+	
+	/* phase holds while frame advance is enabled; the table *
+	 * may have found no room                                 */
+	if (FrameAdvance_IsEnabled(gl) == true || !g.cur->wobble)
+		return 0;
+	
+	wb = g.cur->wobble + op->time;
+	if (++op->time >= WOBBLE_STEPS)
+		op->time = 0;
+	
+	external_func_800AA76C(&gl->view, wb->rot[0], wb->rot[1], wb->rot[2]);
+	external_func_800AA78C(&gl->view, wb->scale[0], wb->scale[1], wb->scale[2]);
+	external_func_800AA7AC(&gl->view, 0.95f);
+	
+	return 0;
+}
+
+/* input of conditionaldraw: the flag's state */
+static
+uint32_t
+conditionaldraw_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	return op->flag->active;
+}
+
+/* point segment at a matrix drawing the mesh as-is if the flag *
+ * is set, or scaled to nothing otherwise                       */
+static
+void
+conditionaldraw(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	gSPSegment(w->work++, op->seg, (void*)&draw_mtx[!!op->input]);
+}
+
+/* returns pointer to raw scene header data */
+static
+void *
+zh_get_current_scene_header(z64_global_t *global)
+{
+	z64_save_context_t *saveCtx = (void*)Z64GL_SAVE_CONTEXT;
+	uint32_t *header = global->scene_file;
+	uint32_t setup = saveCtx->scene_setup_index;
+	
+	if (setup && *header == 0x18000000)
+	{
+		uint32_t *list = (void*)zh_seg2ram(header[1]);
+		
+		/* the correct way */
+		for (int i = setup - 1; i >= 0; --i)
+			if (list[i])
+				return (void*)zh_seg2ram(list[i]);
+		
+		/* the wrong but faster way */
+//		if (list[i])
+//			header = zh_seg2ram(list[i]);
+	}
+	
+	return header;
+}
+
+
+static
+inline
+struct anim *
+get_0x1A(void* _scene, z64_global_t *global)
+{
+	u32 *scene = _scene;
+	u32 *header = scene;
+	u32 *mainheader = global->scene_file;
+	
+	if (!scene)
+		return 0;
+	
+	/* while current header command is not end command */
+    while (*header != 0x14000000) {
+        /* animated texture list */
+        if (*header == 0x1A000000) {  
+            return AADDR(mainheader,AVAL(header,u32,4) & 0xFFFFFF);   
+        }
+         
+        /* advance to next header command */
+        header += 2;
+    }
+	
+	/* failed to locate 0x1A command */
+	return 0;
+}
+
+/* fill existing display list with zeroes */
+static
+inline
+void
+unused_dl(Gfx **work)
+{
+	gDPNoOp((*work)++);
+	gSPEndDisplayList((*work)++);
+}
+
+/* end display list; nothing past an unsupported type is drawn */
+static
+void
+unused(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	/* nothing written yet: use the shared one instead */
+	if (w->work == w->start)
+		w->start = (Gfx*)end_dl;
+	else if (w->start != end_dl)
+		unused_dl(&w->work);
+}
+
+/* input of steps whose commands never change */
+static
+uint32_t
+no_input(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+	return 0;
+}
+
+/* steps writing no commands */
+static
+void
+no_emit(z64_global_t *gl, struct segwork *w, struct op *op)
+{
+}
+
+/* handlers of each animation type */
+static const struct
+{
+	opinput  input;
+	opemit   emit;
+} optable[] =
+{
+	/* vanilla Majora's Mask features */
+	{ scroll_input, scroll }                         /* 0x0000: scroll one layer             */
+	, { scroll_input, scroll }                       /* 0x0001: scroll two layers            */
+	, { no_input, unused }                           /* 0x0002: cycle through color list     */
+	, { no_input, unused }                           /* 0x0003: unused in MM                 */
+	, { no_input, unused }                           /* 0x0004: color easing with keyframes  */
+	, { no_input, unused }                           /* 0x0005: flag-based texture scrolling */
+	, { no_input, unused }                           /* 0x0006: nothing                      */
+	
+	/* extended functionality */
+	, { pointer_flag, no_emit }                      /* 0x0007: pointer changes based on flag*/
+	, { scroll_flag_input, scroll_flag }             /* 0x0008: scroll tiles based on flag   */
+	, { color_loop_input, color_loop }               /* 0x0009: loop through color list      */
+	, { color_loop_flag_input, color_loop }          /* 0x000A: ... with flag                */
+	, { pointer_sequence, no_emit }                  /* 0x000B: loop through pointer list    */
+	, { pointer_sequence_flag, pointer_skipped }     /* 0x000C: ... with flag                */
+	, { pointer_sequence, no_emit }                  /* 0x000D: ... each has its own time    */
+	, { pointer_sequence_flag, pointer_skipped }     /* 0x000E: ... with flag                */
+	, { cameraeffect, no_emit }                      /* 0x000F: camera effect if flag is set */
+	, { conditionaldraw_input, conditionaldraw }     /* 0x0010: draw if flag is set          */
+	, { pointer_sequence, no_emit }                  /* 0x0011: loop through spaced pointers */
+	, { pointer_sequence_flag, pointer_skipped }     /* 0x0012: ... with flag                */
+	, { palette_input, palette }                     /* 0x0013: loop through palettes        */
+	, { atlas_input, atlas }                         /* 0x0014: flipbook within one texture  */
+	, { scroll_input, scroll }                       /* 0x0015: scroll any number of tiles   */
+	, { scroll_flag_input, scroll_tiles_flag }       /* 0x0016: ... with flag                */
+	, { color_loop_input, color_loop }               /* 0x0017: loop through packed colors   */
+	, { color_loop_flag_input, color_loop }          /* 0x0018: ... with flag                */
+};
+
+/* returns most commands a step writes in one frame */
+static
+int
+op_size(struct op *op)
+{
+	struct colortimeline view;
+	struct colortimeline *tl;
+	struct scrolllayer *sl;
+	int num;
+	
+	switch (op->type)
+	{
+		/* pointers */
+		case 0x0007:
+		case 0x000B:
+		case 0x000C:
+		case 0x000D:
+		case 0x000E:
+		case 0x0011:
+		case 0x0012:
+		
+		/* no display list */
+		case 0x000F:
+			return 0;
+		
+		case 0x0010:
+			return 1;
+		
+		/* gDPLoadTLUT */
+		case 0x0013:
+			return 6;
+		
+		case 0x0000:
+		case 0x0008:
+		case 0x0014:
+			return 2;
+		
+		case 0x0001:
+			return 4;
+		
+		/* gDPTileSync and gDPSetTileSize for each tile */
+		case 0x0015:
+		case 0x0016:
+			if (!(sl = op->data))
+				return 0;
+			for (num = 2; !sl->last; ++sl)
+				num += 2;
+			return num;
+		
+		case 0x0009:
+		case 0x000A:
+		case 0x0017:
+		case 0x0018:
+			if (!(tl = color_timeline(op, &view)))
+				return 0;
+			return !!(tl->which & COLORKEY_PRIM)
+				+ !!(tl->which & COLORKEY_ENV)
+			;
+	}
+	
+	/* unused_dl */
+	return 2;
+}
+
+/* compiles one list item into a step */
+static
+void
+op_compile(z64_global_t *gl, struct op *op, struct anim *item)
+{
+	struct flag *f;
+	void *data = mkabs(gl, item->data);
+	
+	op->type = item->type;
+	if (item->type < sizeof(optable) / sizeof(*optable))
+	{
+		op->input_func = optable[item->type].input;
+		op->emit = optable[item->type].emit;
+	}
+	else
+	{
+		op->input_func = no_input;
+		op->emit = unused;
+	}
+	op->input = 0;
+	op->data = data;
+	op->seg = abs_int(item->seg) + 7;
+	op->clock = 0;
+	op->time = 0;
+	op->raw = 0;
+	
+	/* only steps driven by gameplay frames alone can hold their *
+	 * input between updates; the others are updated every frame */
+	op->every = 0;
+	op->wait = 0;
+	if (item->every > 1
+		&& (item->type <= 0x0001
+			|| item->type == 0x0009
+			|| (item->type >= 0x0013 && item->type <= 0x0015)
+			|| item->type == 0x0017
+		)
+	)
+		op->every = item->every - 1;
+	
+	/* items testing identical flags share one result */
+	f = anim_flag(item->type, data);
+	op->flag = f ? g.cur->flags + flag_register(gl, f) : 0;
+	
+	switch (item->type)
+	{
+		/* scroll layers are compiled with wrapping precomputed */
+		case 0x0000:
+		case 0x0001:
+			op->data = scroll_compile(data, item->type + 1);
+			break;
+		
+		/* color lists (packed ones too) are compiled into timelines, *
+		 * which follow gameplay_frames (flagged ones only while set) */
+		case 0x0009:
+		case 0x000A:
+		case 0x0017:
+		case 0x0018:
+		{
+			struct colortimeline view;
+			struct colortimeline *tl = color_compile(item->type, data, 0);
+			
+			/* no room: keys are read in place (see color_timeline) */
+			if (!tl && data)
+			{
+				if (!g.quiet)
+					diag("color list %08X read in place\n", item->data);
+				op->raw = 1;
+				tl = color_compile(item->type, data, &view);
+			}
+			else
+				op->data = tl;
+			
+			if (tl)
+				op->clock = clock_register(CLOCK_GAMEPLAY, 0, 0, tl->period);
+			break;
+		}
+		
+		/* pointers are resolved now */
+		case 0x0007:
+			op->data = ptrtable_new(((struct pointer_flag*)data)->ptr, 2);
+			break;
+		
+		/* pointer lists are compiled into sequences; those *
+		 * without flags follow gameplay_frames, the others *
+		 * count frames their flag is set, starting here    */
+		case 0x000B:
+		case 0x000C:
+		{
+			struct pointer_loop *pl = data;
+			struct sequence *sq;
+			
+			if (item->type == 0x000C)
+				pl = &((struct pointer_loop_flag*)data)->list;
+			sq = sequence_compile(
+				pl->ptr, 0, 0, pl->dur, pl->each, 0, f ? f->freeze : 0
+			);
+			
+			/* frozen: time advances only while the flag is set; *
+			 * otherwise, it keeps running regardless            */
+			op->data = sq;
+			if (sq && item->type == 0x000B)
+				op->clock = clock_register(CLOCK_GAMEPLAY, 0, 0, sq->period);
+			else if (sq)
+				op->clock = clock_register(
+					sq->freeze > 1 ? CLOCK_FREE : CLOCK_FLAG
+					, op->flag, pl->time, sq->period
+				);
+			break;
+		}
+		
+		case 0x000D:
+		case 0x000E:
+		{
+			struct pointer_timeloop *pt = data;
+			struct sequence *sq;
+			int num = pt->num;
+			
+			if (item->type == 0x000E)
+			{
+				pt = &((struct pointer_timeloop_flag*)data)->list;
+				num = pt->num;
+			}
+			
+			/* at least one pointer, and the end frame */
+			op->data = 0;
+			if (num < 2)
+				break;
+			
+			/* each[] holds one more entry than there are pointers: *
+			 * the frame the cycle ends                             */
+			sq = sequence_compile(
+				(void*)(pt->each + num + !(num & 1))
+				, pt->each
+				, num - 1
+				, pt->each[num - 1]
+				, 0
+				, 0
+				, 0
+			);
+			
+			op->data = sq;
+			if (sq)
+				op->clock = clock_register(
+					item->type == 0x000D ? CLOCK_GAMEPLAY : CLOCK_FLAG
+					, op->flag, pt->time, sq->period
+				);
+			break;
+		}
+		
+		/* evenly spaced pointers; like 0x000B and 0x000C, but *
+		 * only the first pointer is stored                    */
+		case 0x0011:
+		case 0x0012:
+		{
+			struct pointer_stride *ps = data;
+			struct sequence *sq;
+			
+			if (item->type == 0x0012)
+				ps = &((struct pointer_stride_flag*)data)->list;
+			sq = sequence_compile(
+				&ps->base, 0, 0, (uint32_t)ps->num * ps->each, ps->each
+				, ps->stride, f ? f->freeze : 0
+			);
+			
+			op->data = sq;
+			if (sq && item->type == 0x0011)
+				op->clock = clock_register(CLOCK_GAMEPLAY, 0, 0, sq->period);
+			else if (sq)
+				op->clock = clock_register(
+					sq->freeze > 1 ? CLOCK_FREE : CLOCK_FLAG
+					, op->flag, 0, sq->period
+				);
+			break;
+		}
+		
+		/* evenly spaced palettes, following gameplay_frames; *
+		 * CI4 palettes live 16 words apart in upper TMEM     */
+		case 0x0013:
+		{
+			struct palette_loop *pl = data;
+			struct palette *pa = arena_alloc(sizeof(*pa));
+			
+			op->data = 0;
+			if (!pa)
+				break;
+			
+			pa->count = pl->count ? pl->count : 16;
+			pa->tmem = 256 + ((pl->pal & 0xF) << 4);
+			pa->base = pl->base;
+			pa->stride = pl->stride ? pl->stride : pa->count * 2;
+			pa->sq = sequence_compile(
+				0, 0, 0, (uint32_t)pl->num * pl->each, pl->each, 0, 0
+			);
+			
+			op->data = pa->sq ? pa : 0;
+			if (pa->sq)
+				op->clock = clock_register(CLOCK_GAMEPLAY, 0, 0, pa->sq->period);
+			break;
+		}
+		
+		/* atlas flipbooks are scheduled like 0x000D, but move *
+		 * the tile instead of writing pointers                */
+		case 0x0014:
+		{
+			struct atlas_timeloop *al = data;
+			struct atlas *at;
+			int num = al->num;
+			int fw = al->w ? al->w : 256;
+			int fh = al->h ? al->h : 256;
+			
+			/* at least one texture frame, and the end frame */
+			op->data = 0;
+			if (num < 2 || !(at = arena_alloc(sizeof(*at))))
+				break;
+			
+			at->tile = al->tile;
+			
+			/* 0 is taken to mean 256, as scroll sizes are */
+			at->w = (fw - 1) << 2;
+			at->h = (fh - 1) << 2;
+			at->step = fh << 2;
+			at->sq = sequence_compile(
+				0, al->each, num - 1, al->each[num - 1], 0, 0, 0
+			);
+			
+			op->data = at->sq ? at : 0;
+			if (at->sq)
+				op->clock = clock_register(CLOCK_GAMEPLAY, 0, 0, at->sq->period);
+			break;
+		}
+		
+		/* any number of tiles, scrolled by one step; with a  *
+		 * flag, time counts frames it is set, like 0x0008    */
+		case 0x0015:
+		{
+			struct scroll_tiles *st = data;
+			
+			op->data = scroll_tiles_compile(st->tile, st->num);
+			break;
+		}
+		
+		case 0x0016:
+		{
+			struct scroll_tiles *st = &((struct scroll_tiles_flag*)data)->list;
+			
+			op->data = scroll_tiles_compile(st->tile, st->num);
+			op->clock = clock_register(CLOCK_FLAG, op->flag, f->frames, 0);
+			break;
+		}
+		
+		/* wobble is read from a table shared by every item */
+		case 0x000F:
+			wobble_compile();
+			break;
+		
+		/* counts frames flag is set, starting where the scene *
+		 * file says; offsets wrap on their own, so no period  */
+		case 0x0008:
+			op->clock = clock_register(CLOCK_FLAG, op->flag, f->frames, 0);
+			break;
+	}
+}
+
+/* returns frames after which a scroll offset repeats */
+static
+uint32_t
+scroll_period(int speed, uint32_t mask)
+{
+	speed &= mask;
+	if (!speed)
+		return 1;
+	
+	/* wraps at a power of two, so this is (mask + 1) / gcd */
+	return (mask + 1) / (speed & -speed);
+}
+
+/* returns frames after which a step's commands repeat, if they *
+ * depend on nothing but gameplay frames; 0 if they do not      */
+static
+uint32_t
+op_period(struct op *op)
+{
+	struct scrolllayer *sl;
+	struct colortimeline view;
+	struct colortimeline *tl;
+	struct palette *pa;
+	struct atlas *at;
+	uint32_t period = 1;
+	
+	/* held input repeats on a cycle of its own, staggered against *
+	 * the other steps; such segments are evaluated as they go     */
+	if (op->every)
+		return 0;
+	
+	switch (op->type)
+	{
+		case 0x0000:
+		case 0x0001:
+		case 0x0015:
+			if (!(sl = op->data))
+				return 1;
+			for ( ; ; ++sl)
+			{
+				uint32_t u = scroll_period(sl->u, sl->umask);
+				uint32_t v = scroll_period(sl->v, sl->vmask);
+				
+				/* all powers of two, so the largest is the lcm */
+				if (u > period)
+					period = u;
+				if (v > period)
+					period = v;
+				if (sl->last)
+					return period;
+			}
+		
+		case 0x0009:
+		case 0x0017:
+			tl = color_timeline(op, &view);
+			return tl ? tl->period : 1;
+		
+		case 0x0013:
+			pa = op->data;
+			return pa ? pa->sq->period : 1;
+		
+		case 0x0014:
+			at = op->data;
+			return at ? at->sq->period : 1;
+		
+		/* flags, pointers, matrices */
+		case 0x0007:
+		case 0x0008:
+		case 0x000A:
+		case 0x000B:
+		case 0x000C:
+		case 0x000D:
+		case 0x000E:
+		case 0x000F:
+		case 0x0010:
+		case 0x0011:
+		case 0x0012:
+		case 0x0016:
+		case 0x0018:
+			return 0;
+	}
+	
+	/* unused_dl */
+	return 1;
+}
+
+/* returns least common multiple of two periods; 0 if too long to bake */
+static
+uint32_t
+period_lcm(uint32_t a, uint32_t b)
+{
+	uint32_t x = a;
+	uint32_t y = b;
+	
+	/* too long already (and long enough to overflow below) */
+	if (b > BAKE_PERIOD)
+		return 0;
+	
+	while (y)
+	{
+		uint32_t t = x % y;
+		
+		x = y;
+		y = t;
+	}
+	
+	a = a / x * b;
+	
+	return (a > BAKE_PERIOD) ? 0 : a;
+}
+
+/* write the baked display lists of a segment, one per frame of cycle */
+static
+void
+segprog_bake(z64_global_t *gl, struct segprog *sp)
+{
+	struct op *op;
+	uint32_t f;
+	
+	for (f = 0; f < sp->clock->period; ++f)
+	{
+		struct segwork w;
+		
+		w.start = w.work = sp->bake + f * sp->size;
+		w.pointer = 0;
+		w.frame = f;
+		
+		/* baked steps read only clocks following gameplay frames */
+		for (op = sp->op; op < sp->op + sp->num; ++op)
+		{
+			if (op->clock)
+				clock_tick(op->clock, f);
+			op->input = op->input_func(gl, &w, op);
+		}
+		
+		for (op = sp->op; op < sp->op + sp->num; ++op)
+			op->emit(gl, &w, op);
+		
+		/* nothing written */
+		if (w.work == w.start || w.start == end_dl)
+			w.work = sp->bake + f * sp->size;
+		
+		gSPEndDisplayList(w.work++);
+	}
 }
 
-/* scroll one tile layer */
+/* bake segment, whose commands depend on gameplay frames alone, *
+ * if they repeat soon enough and fit in `budget` bytes; returns *
+ * bytes used                                                    */
 static
-inline
-void
-scroll(z64_global_t *gl, Gfx **work, struct scroll *sc)
+uint32_t
+segprog_try_bake(z64_global_t *gl, struct segprog *sp, uint32_t budget)
 {
-	uint32_t frame = gl->gameplay_frames;
-	Gfx *dl = Gfx_TexScroll(gl->common.gfx_ctxt
-		, 0, sc->u * frame, -(sc->v * frame), sc->w, sc->h // xywh[0]
-	);
+	struct op *op;
+	uint32_t period = 1;
+	uint32_t bytes;
+	
+	for (op = sp->op; op < sp->op + sp->num && period; ++op)
+	{
+		uint32_t p = op_period(op);
+		
+		period = p ? period_lcm(period, p) : 0;
+	}
 	
-	gSPDisplayList((*work)++, dl);
+	/* not periodic, or too long */
+	if (!period)
+		return 0;
+	
+	bytes = period * sp->size * sizeof(Gfx);
+	if (bytes > budget || !(sp->bake = arena_alloc(bytes)))
+		return 0;
+	
+	sp->clock = clock_register(CLOCK_GAMEPLAY, 0, 0, period);
+	segprog_bake(gl, sp);
+	
+	return bytes;
 }
 
-/* scroll two tile layers */
+/* returns baked display list for the current frame */
 static
 inline
-void
-scroll_two(z64_global_t *gl, Gfx **work, struct scroll *sc)
+Gfx *
+segprog_baked(struct segprog *sp)
 {
-	struct scroll *sc1 = sc + 1;
-	uint32_t frame = gl->gameplay_frames;
-	Gfx *dl = Gfx_TwoTexScroll(gl->common.gfx_ctxt
-		, 0, sc->u * frame, -(sc->v * frame), sc->w, sc->h // xywh[0]
-		, 1, sc1->u * frame, -(sc1->v * frame), sc1->w, sc1->h // xywh[1]
-	);
-	
-	gSPDisplayList((*work)++, dl);
+	return sp->bake + sp->clock->local * sp->size;
 }
 
-/* scroll tiles based on flag */
+/* returns 1 if no item before `item` writes its segment */
 static
-inline
-void
-scroll_flag(z64_global_t *gl, Gfx **work, struct scroll_flag *scroll)
+int
+anim_seg_first(struct anim *src, struct anim *item)
 {
-	struct scroll *sc = scroll->sc;
-	struct scroll *sc1 = sc + 1;
-	uint16_t frame = scroll->flag.frames;
+	struct anim *other;
 	
-	if (flag(gl, &scroll->flag))
-		scroll->flag.frames++;
-	
-	gDPSetTileSize(
-		(*work)++
-		, 0,  sc->u * frame,  sc->v * frame,  sc->w,  sc->h
-	);
+	for (other = src; other < item; ++other)
+		if (abs_int(other->seg) == abs_int(item->seg))
+			return 0;
 	
-	gDPSetTileSize(
-		(*work)++
-		, 1, sc1->u * frame, sc1->v * frame, sc1->w, sc1->h
-	);
+	return 1;
 }
 
-
-extern void external_func_800AA76C(void* view, f32 arg1, f32 arg2, f32 arg3);
-		asm("external_func_800AA76C = 0x800AA76C");
-
-extern void external_func_800AA78C(void* view, f32 arg1, f32 arg2, f32 arg3);
-		asm("external_func_800AA78C = 0x800AA78C");
-
-extern void external_func_800AA7AC(void* view, f32 arg1);
-		asm("external_func_800AA7AC = 0x800AA7AC");
-
-extern s32 FrameAdvance_IsEnabled(z64_global_t *gl);
-		asm("FrameAdvance_IsEnabled = 0x800C0D28");
-
-extern void external_func_8009BEEC(z64_global_t *gl);
-		asm("external_func_8009BEEC = 0x8009BEEC");
-
-
-/* change pointer as time progresses (each pointer has its own time) */
-/* skipped if flag is undesirable */
+/* compile animation list into the current listcache; the *
+ * scene file itself is never written to                  */
 static
-int
-cameraeffect(z64_global_t *gl, Gfx **work, struct cameraeffect *cam) //TODO
+void
+list_compile(z64_global_t *gl, struct anim *src)
 {
-	u8 cameratype = cam->cameratype;
-	if (!flag(gl, &cam->flag))
-		return 0;
-
-	if (cameratype == 0)
-	{
-		external_func_8009BEEC(gl); //camera shake
-	}
-	else //jabu jabu
+	struct listcache *c = g.cur;
+	struct segprog *sp;
+	struct anim *item;
+	struct op *op;
+	uint32_t bake = BAKE_BUDGET;
+	int num;
+	int segs = 0;
+	int stagger = 0;
+	
+	c->arena_next = c->arena;
+	c->arena_want = 0;
+	c->arena_need = 0;
+	c->flags_num = 0;
+	c->clocks_num = 0;
+	c->wobble = 0;
+	c->ptrtables = 0;
+	c->segs_used = 0;
+	c->prog_num = 0;
+	c->prog_size = 0;
+	
+	if (!src)
+		return;
+	
+	/* each item is one step, testing at most one flag and reading *
+	 * at most one clock; each segment may read one more, if baked */
+	for (num = 1; src[num - 1].seg > 0; ++num)
+		;
+	for (item = src; item < src + num; ++item)
+		segs += anim_seg_first(src, item);
+	
+	/* reserved before any step is compiled, so steps generating a *
+	 * lot cannot leave the list without room for these            */
+	c->prog = arena_alloc(sizeof(*c->prog) * segs);
+	c->flags = arena_alloc(sizeof(*c->flags) * num);
+	c->clocks = arena_alloc(sizeof(*c->clocks) * (num + segs));
+	
+	/* too large to animate at all */
+	if (!c->prog || !c->flags || !c->clocks)
 	{
-		static s16 D_8012A39C = 538;
-    	static s16 D_8012A3A0 = 4272;
-
-    	f32 temp;
-
-
-    	if (FrameAdvance_IsEnabled(gl) != true) {
-        D_8012A39C += 1820;
-        D_8012A3A0 += 1820;
-
-        temp = 0.020000001f;
-        external_func_800AA76C(&gl->view, ((360.00018f / 65535.0f) * (M_PI / 180.0f)) * temp * Math_Coss(D_8012A39C),
-                      ((360.00018f / 65535.0f) * (M_PI / 180.0f)) * temp * Math_Sins(D_8012A39C),
-                      ((360.00018f / 65535.0f) * (M_PI / 180.0f)) * temp * Math_Sins(D_8012A3A0));
-        external_func_800AA78C(&gl->view, 1.f + (0.79999995f * temp * Math_Sins(D_8012A3A0)),
-                      1.f + (0.39999998f * temp * Math_Coss(D_8012A3A0)), 1.f + (1 * temp * Math_Coss(D_8012A39C)));
-        external_func_800AA7AC(&gl->view, 0.95f); 
-
-
-
-     
-    }
-
-
+		if (!g.quiet)
+			diag("list of %d items does not fit in 0x%X bytes\n", num, c->arena_size);
+		return;
 	}
 	
-
-	return 1;
-}
-
-/* change pointer as time progresses (each pointer has its own time) */
-/* skipped if flag is undesirable */
-static
-int
-conditionaldraw(z64_global_t *gl, Gfx **work, struct conditionaldraw *_ptr, int seg)
-{
-	Matrix_Push();
-	if (!flag(gl, &_ptr->flag))
+	/* items are grouped by segment, in order of first appearance, *
+	 * so each segment is written once; the steps of every segment *
+	 * are reserved before any is compiled, so a segment without   *
+	 * room draws nothing, and leaves the others as they are       */
+	for (item = src; item < src + num; ++item)
 	{
-		Matrix_Scale(0.0f, 0.0f, 0.0f, MTXMOD_NEW);
+		struct anim *other;
+		
+		if (!anim_seg_first(src, item))
+			continue;
+		
+		sp = c->prog + c->prog_num++;
+		sp->dl = 0;
+		sp->num = 0;
+		sp->size = 0;
+		sp->seg = abs_int(item->seg) + 7;
+		sp->flip = 0;
+		sp->bake = 0;
+		
+		for (other = item; other < src + num; ++other)
+			if (abs_int(other->seg) == abs_int(item->seg))
+				sp->num += 1;
+		
+		sp->op = arena_alloc(sizeof(*sp->op) * sp->num);
+		if (!sp->op)
+		{
+			if (!g.quiet)
+				diag("segment %02X does not fit\n", sp->seg);
+			sp->num = 0;
+		}
 	}
-	else
+	
+	c->arena_need = c->arena_want;
+	
+	/* within a segment, the original order is kept, so the first *
+	 * pointer written wins                                        */
+	for (sp = c->prog; sp < c->prog + c->prog_num; ++sp)
 	{
-		Matrix_Scale(1.0f, 1.0f, 1.0f, MTXMOD_NEW);
+		op = sp->op;
+		for (item = src; item < src + num && op < sp->op + sp->num; ++item)
+		{
+			if (abs_int(item->seg) + 7 != sp->seg)
+				continue;
+			
+			op_compile(gl, op, item);
+			
+			/* stagger updates, so items sharing an interval do *
+			 * not all update on the same frame                 */
+			if (op->every)
+				op->wait = stagger++ % (op->every + 1);
+			sp->size += op_size(op);
+			++op;
+		}
 	}
-
-	gSPSegment((*work)++, seg, Matrix_NewMtx(gl->common.gfx_ctxt, 0));
-
-	matrix_pop();
-
-
-
-	return 1;
-}
-
-
-
-/* returns pointer to raw scene header data */
-static
-void *
-zh_get_current_scene_header(z64_global_t *global)
-{
-	z64_save_context_t *saveCtx = (void*)Z64GL_SAVE_CONTEXT;
-	uint32_t *header = global->scene_file;
-	uint32_t setup = saveCtx->scene_setup_index;
 	
-	if (setup && *header == 0x18000000)
+	for (sp = c->prog; sp < c->prog + c->prog_num; ++sp)
 	{
-		uint32_t *list = (void*)zh_seg2ram(header[1]);
+		/* no display list is needed if a pointer is always written; *
+		 * steps left without data (for want of room) write none     */
+		for (op = sp->op; op < sp->op + sp->num; ++op)
+			if ((op->type == 0x0007
+				|| op->type == 0x000B
+				|| op->type == 0x000D
+				|| op->type == 0x0011
+				) && op->data
+			)
+				sp->size = 0;
 		
-		/* the correct way */
-		for (int i = setup - 1; i >= 0; --i)
-			if (list[i])
-				return (void*)zh_seg2ram(list[i]);
+		sp->buf[0] = sp->buf[1] = 0;
+		if (!sp->size)
+			continue;
 		
-		/* the wrong but faster way */
-//		if (list[i])
-//			header = zh_seg2ram(list[i]);
+		/* room for gSPEndDisplayList */
+		sp->size += 1;
+		
+		/* baked segments are never evaluated, so need no display lists */
+		bake -= segprog_try_bake(gl, sp, bake);
+		if (sp->bake)
+			continue;
+		
+		/* two display lists, so one can be rewritten while the RCP  *
+		 * may still be reading the other; if there is no room, the *
+		 * display list is written to graphics memory every frame   */
+		sp->buf[0] = arena_alloc(sizeof(Gfx) * sp->size);
+		sp->buf[1] = arena_alloc(sizeof(Gfx) * sp->size);
+		if (!sp->buf[1])
+		{
+			sp->buf[0] = sp->buf[1] = 0;
+			c->prog_size += sp->size;
+		}
 	}
-	
-	return header;
 }
 
-
+/* release a compiled list */
 static
-inline
-struct anim *
-get_0x1A(void* _scene, z64_global_t *global)
+void
+list_free(struct listcache *c)
 {
-	u32 *scene = _scene;
-	u32 *header = scene;
-	u32 *mainheader = global->scene_file;
+	if (g.cur == c)
+		g.cur = 0;
 	
-	if (!scene)
-		return 0;
-	
-	/* while current header command is not end command */
-    while (*header != 0x14000000) {
-        /* animated texture list */
-        if (*header == 0x1A000000) {  
-            return AADDR(mainheader,AVAL(header,u32,4) & 0xFFFFFF);   
-        }
-         
-        /* advance to next header command */
-        header += 2;
-    }
-	
-	/* failed to locate 0x1A command */
-	return 0;
+	if (c != &g.none)
+		zelda_free(c);
 }
 
-/* fill existing display list with zeroes */
+/* compile animation list into a new listcache, holding all that   *
+ * it generates; storage needed is known only once it is compiled,  *
+ * so it is compiled again with what it asked for, if that was more *
+ * (steps without room ask for nothing more, so this can take more  *
+ * than one try); if the heap runs out, the last size it gave is    *
+ * used, and steps that do not fit fall back (see op_compile)       */
 static
-inline
-void
-unused_dl(Gfx **work)
+struct listcache *
+list_new(z64_global_t *gl, struct anim *src)
 {
-	gDPNoOp((*work)++);
-	gSPEndDisplayList((*work)++);
+	struct listcache *c = 0;
+	uint32_t size = ARENA_SIZE;
+	uint32_t need = 0;
+	uint32_t fit = 0;
+	int tries;
+	
+	g.quiet = 1;
+	for (tries = 0; tries < LIST_TRIES; ++tries)
+	{
+		c = zelda_malloc(sizeof(*c) + size);
+		
+		/* the heap has no room for all of it: settle for room for *
+		 * every step, whose data falls back, else for what fit last */
+		if (!c && fit)
+		{
+			size = (need > fit && need < size) ? need : fit;
+			c = zelda_malloc(sizeof(*c) + size);
+			if (!c && size != fit)
+				c = zelda_malloc(sizeof(*c) + (size = fit));
+			tries = LIST_TRIES;
+		}
+		if (!c)
+			break;
+		
+		g.cur = c;
+		c->arena_size = size;
+		list_compile(gl, src);
+		if (c->arena_want <= size || tries + 1 >= LIST_TRIES)
+			break;
+		
+		fit = size;
+		size = c->arena_want;
+		need = c->arena_need;
+		list_free(c);
+		c = 0;
+	}
+	g.quiet = 0;
+	
+#ifdef Z64SCENE_HOST
+	/* compiled once more, to tell what did not fit; the result is *
+	 * the same, so only the host benchmark, which reports it, does */
+	if (c && c->arena_want > c->arena_size)
+	{
+		diag(
+			"list of scene %d wants 0x%X bytes, 0x%X found\n"
+			, gl->scene_index, c->arena_want, c->arena_size
+		);
+		g.cur = c;
+		list_compile(gl, src);
+	}
+#endif
+	
+	return c;
 }
 
-/* fill a segment with zeroes */
+/* compile the animation list of the scene setup now loaded, in *
+ * place of the one compiled before; only one is kept, as in game *
+ * a new setup comes with a new play state, which clears the zelda *
+ * arena, so older lists would never be used again                 */
 static
-inline
-void
-unused_segment(z64_global_t *gl, int seg)
+struct listcache *
+list_load(z64_global_t *gl)
 {
-	z64_gfx_t *gfx = gl->common.gfx_ctxt;
-	Gfx *buf;
-	Gfx *Obuf;
+	z64_save_context_t *saveCtx = (void*)Z64GL_SAVE_CONTEXT;
+	struct listcache *c;
 	
-	buf = Obuf = graph_alloc(gfx, 16);
+	if (g.cur)
+		list_free(g.cur);
+	c = list_new(gl, get_0x1A(zh_get_current_scene_header(gl), gl));
 	
-	unused_dl(&buf);
+	/* no room at all */
+	if (!c)
+	{
+		diag("no room for list of scene %d\n", gl->scene_index);
+		c = &g.none;
+		g.cur = c;
+		list_compile(gl, 0);
+	}
 	
-	segment(gl, seg, Obuf);
+	c->scene_file = gl->scene_file;
+	c->gl = gl;
+	c->scene = gl->scene_index;
+	c->setup = saveCtx->scene_setup_index;
+	
+	return g.cur = c;
 }
 
 
@@ -745,243 +2587,179 @@ void
 main(z64_global_t *gl)
 {
 	//
-	/* persistent storage */
-	static struct anim *list = 0;
-	static uint16_t last_scene = -1;
-	
 	/* temporary variables */
-	struct anim *item;
+	z64_save_context_t *saveCtx = (void*)Z64GL_SAVE_CONTEXT;
+	struct listcache *c;
+	struct segprog *sp;
+	Gfx *setup;
+	Gfx *work;
 	z64_disp_buf_t *buf;
 	z64_gfx_t *gfx_ctxt;
 	Gfx todo;
 	uint16_t scene;
-	int prev_seg = 0;
-	Gfx *work = 0;
-	Gfx *Owork = 0; // = 0 is not necessary
-	int has_written_pointer = 0;  /* used to test if pointer written */
+	int setup_size;
+	int i;
 	
 	scene = gl->scene_index;	
 	gfx_ctxt = (gl->common).gfx_ctxt;
 	
-	if (list != NULL && list->pad != 0xDE)
-		last_scene = -1;
-
-	
-	/* re-parse scene header on change */
-	if (scene != last_scene)
-	{
-		list = get_0x1A(zh_get_current_scene_header(gl),gl);
-		last_scene = scene;
-		
-		/* preprocess the list, converting to faster format */
-		if (list)
-		{
-			list->pad = 0xDE;
-			for (item = list; ; ++item)
-			{
-				int8_t Oseg = item->seg;
-				
-				/* this math is now only necessary at load time */
-				item->seg = abs_int(item->seg) + 7;
-				item->data = mkabs(gl, item->data);
-				
-				/* negative segment value indicates list end */
-				if (Oseg <= 0)
-				{
-					item->seg |= 0x80;
-					break;
-				}
-			}
-		}
-	}
+	/* gameplay_frames restarting means a new play state, which *
+	 * cleared the zelda arena, and the compiled list with it; a *
+	 * respawn keeps the same scene and setup, so this is all    *
+	 * that tells the list is gone                                */
+	if (gl->gameplay_frames < g.frames)
+		g.cur = 0;
+	g.frames = gl->gameplay_frames;
+	
+	/* compile list on change of scene or setup */
+	c = g.cur;
+	if (!c
+		|| c->scene != scene
+		|| c->setup != saveCtx->scene_setup_index
+		|| c->scene_file != gl->scene_file
+		|| c->gl != gl
+	)
+		c = list_load(gl);
 	
 	/* scene render init functions always start with this */
 	z_debug_graph_alloc(&todo, gfx_ctxt, "wow", __LINE__);
 	
-	/* default environment color (opa) */
+	/* one setup display list, holding default colors and every *
+	 * ram segment, is shared by poly_opa and poly_xlu; graphics *
+	 * memory for segments lacking persistent display lists      *
+	 * follows it, so both are requested at once                 */
+	setup_size = 2 + (c->prog_num ? c->prog_num : 8) + 1;
+	setup = graph_alloc(gfx_ctxt, (setup_size + c->prog_size) * sizeof(*setup));
+	work = setup + setup_size;
+	
 	buf = &(gfx_ctxt->poly_opa);
-	gDPPipeSync(buf->p++);
-	gDPSetEnvColor(buf->p++, 128, 128, 128, 128);
+	gSPDisplayList(buf->p++, setup);
 	
-	/* default environment color (xlu) */
 	buf = &(gfx_ctxt->poly_xlu);
-	gDPPipeSync(buf->p++);
-	gDPSetEnvColor(buf->p++, 128, 128, 128, 128);
+	gSPDisplayList(buf->p++, setup);
+	
+	/* default environment color */
+	gDPPipeSync(setup++);
+	gDPSetEnvColor(setup++, 128, 128, 128, 128);
 	
 	// testing
 	//scroll_two(gl, 8, 0);
 	
 	/* no animation list */
-	if (!list)
+	if (!c->prog_num)
 	{
-		int i;
-		
 		/* propagate ram segments with defaults so scene *
 		 * headers lacking a 0x1A command do not crash   */
 		for (i = 0x08; i <= 0x0F; ++i)
-			unused_segment(gl, i);
+			segment(&setup, i, (void*)end_dl);
 		
 		goto cleanup;
 	}
 	
-	/* parse every item in animation list */
-	for (item = list; ; ++item)
+	/* pointers resolved at load time must follow segments moved */
+	if (c->segs_used)
+		list_relocate(c);
+	
+	/* evaluate every flag the list tests */
+	for (i = 0; i < c->flags_num; ++i)
+		c->flags[i].active = flag(gl, c->flags + i);
+	
+	/* then every clock, so each cycle position is worked out once */
+	for (i = 0; i < c->clocks_num; ++i)
+		clock_tick(c->clocks + i, gl->gameplay_frames);
+	
+	/* run each segment's steps */
+	for (sp = c->prog; sp < c->prog + c->prog_num; ++sp)
 	{
-		int seg = item->seg & 0x7F;
-		void *data = item->data;
+		struct segwork w;
+		struct op *op;
+		int dirty = !sp->dl;
 		
-		/* begin work on new dlist */
-		if (seg != prev_seg || !work)
+		/* commands were written ahead of time */
+		if (sp->bake)
 		{
-			/* flush generated dlist's contents to ram segment */
-			if (work)
+			segment(&setup, sp->seg, segprog_baked(sp));
+			continue;
+		}
+		
+		w.pointer = 0;
+		w.frame = gl->gameplay_frames;
+		
+		for (op = sp->op; op < sp->op + sp->num; ++op)
+		{
+			uint32_t input;
+			
+			/* input is held between updates, unless the display *
+			 * list has to be written anyway                     */
+			if (op->wait)
 			{
-				/* is display list */
-				if (work > Owork)
-					gSPEndDisplayList(work++);
-				
-				segment(gl, prev_seg, Owork);
+				op->wait -= 1;
+				if (sp->dl)
+					continue;
 			}
+			else
+				op->wait = op->every;
 			
-			/* request space for 8 opcodes in graphics memory */
-			Owork = work = graph_alloc(gl->common.gfx_ctxt, 8 * 8);
-			prev_seg = seg;
+			bench_begin(op->type);
+			input = op->input_func(gl, &w, op);
+			bench_end(op->type);
 			
-			/* zero-initialize any variables needing it */
-			has_written_pointer = 0;
+			if (input != op->input)
+			{
+				op->input = input;
+				dirty = 1;
+			}
 		}
 		
-		switch (item->type)
+		/* a pointer takes the place of any commands; if those *
+		 * changed meanwhile, rewrite them when next needed    */
+		if (w.pointer)
 		{
-			/* scroll one layer */
-			case 0x0000:
-				scroll(gl, &work, data);
-				break;
-			
-			/* scroll two layers */
-			case 0x0001:
-				scroll_two(gl, &work, data);
-				break;
-			
-			/* cycle through color list (advance one per frame) */
-			case 0x0002:
-				unused_dl(&work);
-				break;
-			
-			/* unused in MM */
-			case 0x0003:
-				unused_dl(&work);
-				break;
-			
-			/* color easing with keyframe support */
-			case 0x0004:
-				unused_dl(&work);
-				break;
-			
-			/* flag-based texture scrolling */
-			/* used only in Sakon's Hideout in MM */
-			case 0x0005:
-				unused_dl(&work);
-				break;
-			
-			/* nothing; data and seg are always 0 when this is used */
-			case 0x0006:
-				unused_dl(&work);
-				break;
-			
-			/* extended functionality */
-			
-			/* pointer changes based on flag */
-			case 0x0007:
-				if (has_written_pointer)
-					break;
-				has_written_pointer = 1;
-				pointer_flag(gl, &work, data);
-				Owork = work;
-				break;
-			
-			/* scroll tiles based on flag */
-			case 0x0008:
-				scroll_flag(gl, &work, data);
-				break;
-			
-			/* loop through color list */
-			case 0x0009:
-				color_loop(gl, &work, data);
-				break;
-			
-			/* loop through color list, with flag */
-			case 0x000A:
-				color_loop_flag(gl, &work, data);
-				break;
-			
-			/* loop through pointer list */
-			case 0x000B:
-				if (has_written_pointer)
-					break;
-				has_written_pointer = 1;
-				pointer_loop(gl, &work, data);
-				Owork = work;
-				break;
-			
-			/* loop through pointer list */
-			/* skipped if flag is undesirable */
-			case 0x000C:
-				if (has_written_pointer)
-					break;
-				if (pointer_loop_flag(gl, &work, data))
-					has_written_pointer = 1;
-				Owork = work;
-				break;
-			
-			/* loop through pointer list (each frame has its own time) */
-			case 0x000D:
-				if (has_written_pointer)
-					break;
-				has_written_pointer = 1;
-				pointer_timeloop(gl, &work, data);
-				Owork = work;
-				break;
-			
-			/* loop through pointer list (each frame has its own time) */
-			/* skipped if flag is undesirable */
-			case 0x000E:
-				if (has_written_pointer)
-					break;
-				if (pointer_timeloop_flag(gl, &work, data))
-					has_written_pointer = 1;
-				Owork = work;
-				break;
-
-			/* camera effect if flag is set */
-			case 0x000F:
-				cameraeffect(gl, &work, data);
-				break;
-
-			/* draw if flag is set */
-			case 0x0010:
-				conditionaldraw(gl, &work, data, seg);
-				break;
-			
-			default:
-				unused_dl(&work);
-				break;
+			if (dirty)
+				sp->dl = 0;
+			segment(&setup, sp->seg, w.pointer);
+			continue;
 		}
 		
-		/* this bit means this is the last item in the list */
-		if (item->seg & 0x80)
+		/* commands are unchanged since last written */
+		if (!dirty && sp->buf[0])
 		{
-			/* flush generated dlist's contents to ram segment */
-			if (work)
-			{
-				/* is display list */
-				if (work > Owork)
-					gSPEndDisplayList(work++);
-				
-				segment(gl, prev_seg, Owork);
-			}
-			break;
+			segment(&setup, sp->seg, sp->dl);
+			continue;
 		}
+		
+		/* write commands */
+		if (sp->buf[0])
+		{
+			sp->flip ^= 1;
+			w.work = sp->buf[sp->flip];
+		}
+		else
+		{
+			w.work = work;
+			work += sp->size;
+		}
+		w.start = w.work;
+		
+		for (op = sp->op; op < sp->op + sp->num; ++op)
+		{
+			bench_begin(op->type);
+			op->emit(gl, &w, op);
+			bench_end(op->type);
+		}
+		
+		/* nothing written */
+		if (w.work == w.start || w.start == end_dl)
+			sp->dl = (Gfx*)end_dl;
+		
+		/* end display list */
+		else
+		{
+			gSPEndDisplayList(w.work++);
+			sp->dl = w.start;
+		}
+		
+		segment(&setup, sp->seg, sp->dl);
 	}
 #if 0
 	/* day, night textures test */
@@ -996,6 +2774,8 @@ main(z64_global_t *gl)
 	);
 #endif
 cleanup:
+	gSPEndDisplayList(setup++);
+	
 //	triangle_test(gl);
 	/* scene render init functions always end with this */
 	z_debug_graph_write(&todo, gfx_ctxt, "wow", __LINE__);